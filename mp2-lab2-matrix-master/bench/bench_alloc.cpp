@@ -0,0 +1,123 @@
+// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// bench_alloc.cpp
+//
+// Подсчет выделений памяти и объема копируемых данных в арифметике
+// векторов и матриц: глобальные operator new/delete подменены счетчиками
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "utcolmatrix.h"
+//---------------------------------------------------------------------------
+
+static size_t AllocCount = 0; // число выделений
+static size_t AllocBytes = 0; // суммарный объем выделений
+
+static void* CountedAlloc(size_t n) // выделение через malloc со счетчиком
+{
+	AllocCount++;
+	AllocBytes += n;
+	if (void *p = malloc(n ? n : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void* operator new(size_t n) { return CountedAlloc(n); }
+void* operator new[](size_t n) { return CountedAlloc(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+void* operator new(size_t n, align_val_t al)
+{
+	AllocCount++;
+	AllocBytes += n;
+	size_t a = static_cast<size_t>(al);
+	if (void *p = aligned_alloc(a, (n + a - 1) / a * a))
+		return p;
+	throw bad_alloc();
+}
+void operator delete(void *p, align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { free(p); }
+
+// Выполнить оператор reps раз и вывести выделения на один оператор
+template <class F>
+void Measure(const char *name, int reps, F f)
+{
+	size_t c0 = AllocCount, b0 = AllocBytes;
+	auto t0 = chrono::steady_clock::now();
+	for (int r = 0; r < reps; r++)
+		f();
+	auto t1 = chrono::steady_clock::now();
+	double ms = chrono::duration<double, milli>(t1 - t0).count() / reps;
+	printf("%-28s %8.2f alloc/op %12.0f bytes/op %10.3f ms/op\n", name,
+		double(AllocCount - c0) / reps, double(AllocBytes - b0) / reps, ms);
+}
+
+int main(int argc, char **argv)
+{
+	int n = (argc > 1) ? atoi(argv[1]) : 2000; // размер матрицы
+	int reps = (argc > 2) ? atoi(argv[2]) : 10;
+	int len = n * (n + 1) / 2;                   // длина вектора той же емкости
+
+	TVector<double> a(len), b(len), c(len), d(len);
+	for (int i = 0; i < len; i++)
+	{
+		a[i] = i;
+		b[i] = 2.0 * i;
+		c[i] = 0.5;
+	}
+	printf("TVector<double>, len = %d\n", len);
+	Measure("d = a + b", reps, [&] { d = a + b; });
+	Measure("d = a + b - c", reps, [&] { d = a + b - c; });
+	Measure("d = (a + b) * 2.0", reps, [&] { d = (a + b) * 2.0; });
+	Measure("d = a - (b + c)", reps, [&] { d = a - (b + c); });
+	Measure("TVector t(a + b)", reps, [&] { TVector<double> t(a + b); });
+	Measure("d += a", reps, [&] { d += a; });
+	Measure("d.Axpy(0.5, a)", reps, [&] { d.Axpy(0.5, a); });
+
+	TMatrix<double> ma(n), mb(n), mc(n), md(n);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+		{
+			ma[i][j] = i + j;
+			mb[i][j] = i - j;
+			mc[i][j] = 1.0;
+		}
+	printf("TMatrix<double>, n = %d\n", n);
+	Measure("md = ma + mb", reps, [&] { md = ma + mb; });
+	Measure("md = ma + mb - mc", reps, [&] { md = ma + mb - mc; });
+	Measure("md = ma - (mb + mc)", reps, [&] { md = ma - (mb + mc); });
+	Measure("TMatrix t(ma + mb)", reps, [&] { TMatrix<double> t(ma + mb); });
+	Measure("md += ma", reps, [&] { md += ma; });
+	Measure("md.Axpy(0.5, ma)", reps, [&] { md.Axpy(0.5, ma); });
+
+	int g = n / 4; // рост матрицы по одному измерению: 0 -> g
+	printf("growth 0 -> %d\n", g);
+	Measure("TMatrix grow by copy", 1, [&]
+	{
+		TMatrix<double> m(0);
+		for (int s = 1; s <= g; s++)
+		{
+			TMatrix<double> t(s);
+			for (int i = 0; i < s - 1; i++)
+				copy_n(m.GetData() + m.GetRowOffset(i), s - 1 - i, t.GetData() + t.GetRowOffset(i));
+			m = move(t);
+		}
+	});
+	Measure("TColMatrix::AppendDimension", 1, [&]
+	{
+		TColMatrix<double> m(0);
+		for (int s = 1; s <= g; s++)
+			m.AppendDimension();
+	});
+
+	TBufferPoolStats st = GetBufferPoolStats();
+	printf("buffer pool: %zu requests, hit rate %.1f%%, %zu bytes retained\n",
+		st.Requests, 100.0 * st.HitRate(), st.RetainedBytes);
+	return 0;
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,407 @@
+// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// bench_matrix.cpp
+//
+// Производительность операций TVector и TMatrix для int, float и double
+// при размерах от 1 до MAX_MATRIX_SIZE. Для каждой операции выводятся
+// нс на элемент, ГБ/с (прочитанные и записанные данные) и ГФЛОП/с;
+// с ключом --json результаты записываются в файл для сравнения запусков.
+// Векторные операции измеряются на векторах длины n(n+1)/2, то есть
+// с тем же числом элементов, что и матрица размера n.
+//
+// bench_matrix [--max n] [--max-mul n] [--max-io n] [--time ms] [--types int,float,double]
+//              [--json file]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "utbatch.h"
+#include "utbinary.h"
+#include "utfixed.h"
+#include "utio.h"
+#include "utreduce.h"
+#include "uttiled.h"
+//---------------------------------------------------------------------------
+
+struct TBenchOptions
+{
+	int MaxSize;    // наибольший размер матрицы
+	int MaxMulSize; // наибольший размер для умножения матриц (работа n^3/6)
+	int MaxIoSize;  // наибольший размер для текстового ввода-вывода
+	double MinTime; // минимальное время измерения одной точки (мс)
+	string Types;   // типы элементов через запятую
+	string Json;    // файл результатов
+};
+
+struct TBenchResult
+{
+	string Type, Op;
+	int N;            // размер матрицы
+	double Elements;  // элементов на операцию
+	double Bytes;     // байт прочитано и записано
+	double Flops;     // арифметических операций
+	int Reps;         // число повторений
+	double Ns;        // время одной операции (нс)
+};
+
+static vector<TBenchResult> Results;
+static volatile double Sink; // результаты, которые нельзя выбросить
+
+// Повторять f, пока суммарное время не превысит MinTime; время одной
+// операции - минимум по трем сериям
+template <class F>
+double TimeOp(const TBenchOptions &opt, int &reps, F f)
+{
+	f(); // прогрев: выделение буферов пула, страницы памяти
+	reps = 1;
+	double best = 1e300, total = 0.0;
+	for (int series = 0; (series < 3) || (total < opt.MinTime * 1e6); series++)
+	{
+		auto t0 = chrono::steady_clock::now();
+		for (int r = 0; r < reps; r++)
+			f();
+		double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+		total += ns;
+		best = min(best, ns / reps);
+		if ((ns < opt.MinTime * 1e6 / 10) && (reps < (1 << 24)))
+			reps *= 2;
+		if (series >= 30)
+			break;
+	}
+	return best;
+}
+
+template <class F>
+void Bench(const TBenchOptions &opt, const char *type, const char *op, int n,
+	double elements, double bytes, double flops, F f)
+{
+	TBenchResult r;
+	r.Type = type;
+	r.Op = op;
+	r.N = n;
+	r.Elements = elements;
+	r.Bytes = bytes;
+	r.Flops = flops;
+	r.Ns = TimeOp(opt, r.Reps, f);
+	Results.push_back(r);
+	printf("%-7s %-18s %6d %12.0f %10.3f %9.2f %9.2f\n", type, op, n, elements,
+		r.Ns / elements, bytes / r.Ns, flops / r.Ns);
+	fflush(stdout);
+}
+
+template <class T>
+void FillVector(TVector<T> &v, int seed)
+{
+	T *p = v.GetData();
+	for (int k = 0; k < v.GetSize(); k++)
+		p[k] = T((k * 7 + seed) % 11 + 1);
+}
+
+template <class T>
+void FillMatrix(TMatrix<T> &m, int seed)
+{
+	T *p = m.GetData();
+	for (int k = 0; k < m.GetPackedSize(); k++)
+		p[k] = T((k * 7 + seed) % 11 + 1);
+}
+
+template <class T>
+void BenchVector(const TBenchOptions &opt, const char *type, int n)
+{
+	int len = n * (n + 1) / 2;
+	double e = len, s = sizeof(T);
+	TVector<T> a(len), b(len), c(len);
+	FillVector(a, 1);
+	FillVector(b, 2);
+	Bench(opt, type, "vector_copy", n, e, 2 * e * s, 0, [&] { TVector<T> t(a); Sink = double(t.GetData()[0]); });
+	Bench(opt, type, "vector_add", n, e, 3 * e * s, e, [&] { c = a + b; });
+	Bench(opt, type, "vector_sub", n, e, 3 * e * s, e, [&] { c = a - b; });
+	Bench(opt, type, "vector_scale", n, e, 2 * e * s, e, [&] { c = a * T(3); });
+	Bench(opt, type, "vector_add3", n, e, 4 * e * s, 2 * e, [&] { c = a + b - c; });
+	Bench(opt, type, "vector_dot", n, e, 2 * e * s, 2 * e, [&] { Sink = double(a * b); });
+	Bench(opt, type, "vector_sum", n, e, e * s, e, [&] { Sink = double(Sum(a)); });
+	Bench(opt, type, "vector_norm2", n, e, e * s, 2 * e, [&] { Sink = double(Norm2(a)); });
+	TVector<T> a2(a); // равные векторы сравниваются целиком
+	Bench(opt, type, "vector_equal", n, e, 2 * e * s, 0, [&] { Sink = (a == a2); });
+	if (n <= opt.MaxIoSize)
+	{
+		Bench(opt, type, "vector_write_txt", n, e, e * s, 0, [&]
+		{
+			ostringstream out;
+			out << a;
+			Sink = double(out.str().size());
+		});
+		ostringstream out;
+		out << a;
+		string text = out.str();
+		Bench(opt, type, "vector_read_txt", n, e, e * s, 0, [&]
+		{
+			istringstream in(text);
+			in >> c;
+		});
+		Bench(opt, type, "vector_write_fast", n, e, e * s, 0, [&]
+		{
+			ostringstream out;
+			WriteText(out, a);
+			Sink = double(out.str().size());
+		});
+		Bench(opt, type, "vector_read_fast", n, e, e * s, 0, [&]
+		{
+			ReadText(text.data(), text.data() + text.size(), c);
+		});
+	}
+	Bench(opt, type, "vector_write_bin", n, e, e * s, 0, [&]
+	{
+		ostringstream out(ios::binary);
+		WriteBinary(out, a);
+		Sink = double(out.tellp());
+	});
+}
+
+template <class T>
+void BenchMatrix(const TBenchOptions &opt, const char *type, int n)
+{
+	double e = double(n) * (n + 1) / 2, s = sizeof(T), nn = n;
+	TMatrix<T> a(n), b(n), c(n);
+	FillMatrix(a, 1);
+	FillMatrix(b, 2);
+	for (int i = 0; i < n; i++) // единичная диагональ: Solve определено для int
+	{
+		a.GetData()[a.GetRowOffset(i)] = T(1);
+		b.GetData()[b.GetRowOffset(i)] = T(1);
+	}
+	TVector<T> x(n), y(n);
+	FillVector(x, 3);
+	Bench(opt, type, "matrix_copy", n, e, 2 * e * s, 0, [&] { TMatrix<T> t(a); Sink = double(t.GetData()[0]); });
+	Bench(opt, type, "matrix_add", n, e, 3 * e * s, e, [&] { c = a + b; });
+	Bench(opt, type, "matrix_sub", n, e, 3 * e * s, e, [&] { c = a - b; });
+	Bench(opt, type, "matrix_scale", n, e, 2 * e * s, e, [&] { c = a * T(3); });
+	TMatrix<T> a2(a);
+	Bench(opt, type, "matrix_equal", n, e, 2 * e * s, 0, [&] { Sink = (a == a2); });
+	Bench(opt, type, "matrix_norm_fro", n, e, e * s, 2 * e, [&] { Sink = double(NormFrobenius(a)); });
+	Bench(opt, type, "matrix_norm1", n, e, (e + nn) * s, 2 * e, [&] { Sink = double(Norm1(a)); });
+	Bench(opt, type, "matrix_norm_inf", n, e, (e + nn) * s, 2 * e, [&] { Sink = double(NormInf(a)); });
+	Bench(opt, type, "matrix_vec", n, e, (e + 2 * nn) * s, 2 * e, [&] { y = a * x; });
+	Bench(opt, type, "matrix_tvec", n, e, (e + 2 * nn) * s, 2 * e, [&] { y = a.MulTransposed(x); });
+	Bench(opt, type, "matrix_solve", n, e, (e + 2 * nn) * s, 2 * e, [&] { y = a.Solve(x); });
+	if (n <= opt.MaxMulSize)
+		Bench(opt, type, "matrix_mul", n, e, 3 * e * s, nn * (nn + 1) * (nn + 2) / 3, [&] { c = a * b; });
+	TTiledMatrix<T> ta(a), tb(b), tc(n);
+	Bench(opt, type, "tiled_vec", n, e, (e + 2 * nn) * s, 2 * e, [&] { y = ta * x; });
+	Bench(opt, type, "tiled_solve", n, e, (e + 2 * nn) * s, 2 * e, [&] { y = ta.Solve(x); });
+	if (n <= opt.MaxMulSize)
+		Bench(opt, type, "tiled_mul", n, e, 3 * e * s, nn * (nn + 1) * (nn + 2) / 3, [&] { tc = ta * tb; });
+	if (n <= opt.MaxIoSize)
+	{
+		Bench(opt, type, "matrix_write_txt", n, e, e * s, 0, [&]
+		{
+			ostringstream out;
+			out << a;
+			Sink = double(out.str().size());
+		});
+		ostringstream out;
+		out << a;
+		string text = out.str();
+		Bench(opt, type, "matrix_read_txt", n, e, e * s, 0, [&]
+		{
+			istringstream in(text);
+			in >> c;
+		});
+		Bench(opt, type, "matrix_write_fast", n, e, e * s, 0, [&]
+		{
+			ostringstream out;
+			WriteText(out, a);
+			Sink = double(out.str().size());
+		});
+		Bench(opt, type, "matrix_read_fast", n, e, e * s, 0, [&]
+		{
+			ReadText(text.data(), text.data() + text.size(), c);
+		});
+	}
+	Bench(opt, type, "matrix_write_bin", n, e, e * s, 0, [&]
+	{
+		ostringstream out(ios::binary);
+		WriteBinary(out, a);
+		Sink = double(out.tellp());
+	});
+}
+
+// Малые матрицы размера N: TMatrix<T, N> (элементы в объекте, код без
+// циклов) и TMatrix<T> того же размера; результат - новая матрица или
+// вектор, как при вычислении локальных якобианов. Элемент (0, 0) читается
+// из Sink, чтобы вычисление не выносилось из цикла повторений
+template <class T, int N>
+void BenchFixed(const TBenchOptions &opt, const char *type)
+{
+	double e = N * (N + 1) / 2.0, s = sizeof(T), nn = N, mf = nn * (nn + 1) * (nn + 2) / 3;
+	TMatrix<T> a(N), b(N);
+	FillMatrix(a, 1);
+	FillMatrix(b, 2);
+	for (int i = 0; i < N; i++)
+	{
+		a.GetData()[a.GetRowOffset(i)] = T(1);
+		b.GetData()[b.GetRowOffset(i)] = T(1);
+	}
+	TVector<T> x(N);
+	FillVector(x, 3);
+	TMatrix<T, N> fa(a), fb(b);
+	typename TMatrix<T, N>::TVec fx;
+	copy_n(x.GetData(), N, fx.begin());
+	Sink = 1;
+	Bench(opt, type, "small_add", N, e, 3 * e * s, e, [&]
+		{ a.GetData()[0] = T(Sink); TMatrix<T> c = a + b; Sink = double(c.GetData()[0]) - 1; });
+	Bench(opt, type, "fixed_add", N, e, 3 * e * s, e, [&]
+		{ fa(0, 0) = T(Sink); TMatrix<T, N> c = fa + fb; Sink = double(c(0, 0)) - 1; });
+	Bench(opt, type, "small_mul", N, e, 3 * e * s, mf, [&]
+		{ a.GetData()[0] = T(Sink); TMatrix<T> c = a * b; Sink = double(c.GetData()[0]); });
+	Bench(opt, type, "fixed_mul", N, e, 3 * e * s, mf, [&]
+		{ fa(0, 0) = T(Sink); TMatrix<T, N> c = fa * fb; Sink = double(c(0, 0)); });
+	Bench(opt, type, "small_solve", N, e, (e + 2 * nn) * s, 2 * e, [&]
+		{ a.GetData()[0] = T(Sink); TVector<T> y = a.Solve(x); Sink = double(y[0]) * 0 + 1; });
+	Bench(opt, type, "fixed_solve", N, e, (e + 2 * nn) * s, 2 * e, [&]
+		{ fa(0, 0) = T(Sink); typename TMatrix<T, N>::TVec y = fa.Solve(fx); Sink = double(y[0]) * 0 + 1; });
+}
+
+// Пакет из BATCH_COUNT матриц размера N (раскладка "структура массивов")
+// и тот же набор отдельных матриц TMatrix<T, N> в цикле; элементов на
+// операцию - всех матриц пакета
+const int BATCH_COUNT = 4096;
+
+template <class T, int N>
+void BenchBatch(const TBenchOptions &opt, const char *type)
+{
+	double e = N * (N + 1) / 2.0 * BATCH_COUNT, s = sizeof(T), nn = N;
+	double mf = nn * (nn + 1) * (nn + 2) / 3 * BATCH_COUNT, vn = nn * BATCH_COUNT;
+	TMatrixBatch<T> a(N, BATCH_COUNT), b(N, BATCH_COUNT), c(N, BATCH_COUNT);
+	TVectorBatch<T> x(N, BATCH_COUNT), y(N, BATCH_COUNT);
+	vector<TMatrix<T, N> > fa(BATCH_COUNT), fb(BATCH_COUNT), fc(BATCH_COUNT);
+	vector<typename TMatrix<T, N>::TVec> fx(BATCH_COUNT), fy(BATCH_COUNT);
+	TMatrix<T> m(N);
+	TVector<T> v(N);
+	for (int k = 0; k < BATCH_COUNT; k++)
+	{
+		FillMatrix(m, k);
+		for (int i = 0; i < N; i++) // единичная диагональ: Solve определено для int
+			m.GetData()[m.GetRowOffset(i)] = T(1);
+		a.Set(k, m);
+		fa[k] = TMatrix<T, N>(m);
+		FillMatrix(m, k + 1);
+		b.Set(k, m);
+		fb[k] = TMatrix<T, N>(m);
+		FillVector(v, k);
+		x.Set(k, v);
+		copy_n(v.GetData(), N, fx[k].begin());
+	}
+	Bench(opt, type, "batch_mul", N, e, 3 * e * s, mf, [&] { c = a * b; });
+	Bench(opt, type, "fixed_loop_mul", N, e, 3 * e * s, mf, [&]
+		{ for (int k = 0; k < BATCH_COUNT; k++) fc[k] = fa[k] * fb[k]; });
+	Bench(opt, type, "batch_vec", N, e, (e + 2 * vn) * s, 2 * e, [&] { y = a * x; });
+	Bench(opt, type, "fixed_loop_vec", N, e, (e + 2 * vn) * s, 2 * e, [&]
+		{ for (int k = 0; k < BATCH_COUNT; k++) fy[k] = fa[k] * fx[k]; });
+	Bench(opt, type, "batch_solve", N, e, (e + 2 * vn) * s, 2 * e, [&] { y = a.Solve(x); });
+	Bench(opt, type, "fixed_loop_solve", N, e, (e + 2 * vn) * s, 2 * e, [&]
+		{ for (int k = 0; k < BATCH_COUNT; k++) fy[k] = fa[k].Solve(fx[k]); });
+	Sink = double(c(0, 0, 0)) + double(y(0, 0)) + double(fc[0](0, 0)) + double(fy[0][0]);
+}
+
+template <class T>
+void BenchType(const TBenchOptions &opt, const char *type, const vector<int> &sizes)
+{
+	for (size_t k = 0; k < sizes.size(); k++)
+	{
+		BenchVector<T>(opt, type, sizes[k]);
+		BenchMatrix<T>(opt, type, sizes[k]);
+	}
+	BenchFixed<T, 3>(opt, type);
+	BenchFixed<T, 8>(opt, type);
+	BenchBatch<T, 4>(opt, type);
+	BenchBatch<T, 8>(opt, type);
+}
+
+static const char* SimdName(TSimdLevel level)
+{
+	switch (level)
+	{
+	case SIMD_SSE2: return "sse2";
+	case SIMD_AVX2: return "avx2";
+	case SIMD_AVX512: return "avx512";
+	default: return "scalar";
+	}
+}
+
+static void WriteJson(const TBenchOptions &opt)
+{
+	FILE *f = fopen(opt.Json.c_str(), "w");
+	if (f == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", opt.Json.c_str());
+		exit(1);
+	}
+	fprintf(f, "{\n  \"benchmark\": \"bench_matrix\",\n  \"simd\": \"%s\",\n"
+		"  \"threads\": %d,\n  \"min_time_ms\": %g,\n  \"results\": [\n",
+		SimdName(GetSimdLevel()), GetNumThreads(), opt.MinTime);
+	for (size_t k = 0; k < Results.size(); k++)
+	{
+		const TBenchResult &r = Results[k];
+		fprintf(f, "    {\"type\": \"%s\", \"op\": \"%s\", \"n\": %d, \"elements\": %.0f, "
+			"\"reps\": %d, \"ns_per_op\": %.1f, \"ns_per_element\": %.6g, "
+			"\"gb_per_s\": %.6g, \"gflop_per_s\": %.6g}%s\n",
+			r.Type.c_str(), r.Op.c_str(), r.N, r.Elements, r.Reps, r.Ns, r.Ns / r.Elements,
+			r.Bytes / r.Ns, r.Flops / r.Ns, (k + 1 < Results.size()) ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+	TBenchOptions opt;
+	opt.MaxSize = MAX_MATRIX_SIZE;
+	opt.MaxMulSize = 2000;
+	opt.MaxIoSize = 2000;
+	opt.MinTime = 200;
+	opt.Types = "int,float,double";
+	for (int k = 1; k < argc; k++)
+	{
+		string a = argv[k];
+		const char *v = (k + 1 < argc) ? argv[k + 1] : "";
+		if (a == "--max") opt.MaxSize = atoi(v);
+		else if (a == "--max-mul") opt.MaxMulSize = atoi(v);
+		else if (a == "--max-io") opt.MaxIoSize = atoi(v);
+		else if (a == "--time") opt.MinTime = atof(v);
+		else if (a == "--types") opt.Types = v;
+		else if (a == "--json") opt.Json = v;
+		else
+		{
+			fprintf(stderr, "usage: bench_matrix [--max n] [--max-mul n] [--max-io n] "
+				"[--time ms] [--types int,float,double] [--json file]\n");
+			return 1;
+		}
+		k++;
+	}
+	opt.MaxSize = min(max(opt.MaxSize, 1), MAX_MATRIX_SIZE);
+
+	vector<int> sizes; // 1, 4, 16, ..., 4^k, затем MaxSize
+	for (int n = 1; n < opt.MaxSize; n *= 4)
+		sizes.push_back(n);
+	sizes.push_back(opt.MaxSize);
+
+	printf("simd %s, threads %d\n", SimdName(GetSimdLevel()), GetNumThreads());
+	printf("%-7s %-18s %6s %12s %10s %9s %9s\n", "type", "op", "n", "elements",
+		"ns/elem", "GB/s", "GFLOP/s");
+	string types = "," + opt.Types + ",";
+	if (types.find(",int,") != string::npos)
+		BenchType<int>(opt, "int", sizes);
+	if (types.find(",float,") != string::npos)
+		BenchType<float>(opt, "float", sizes);
+	if (types.find(",double,") != string::npos)
+		BenchType<double>(opt, "double", sizes);
+	if (!opt.Json.empty())
+		WriteJson(opt);
+	return 0;
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,467 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utbatch.h
+//
+// Пакеты из count верхнетреугольных матриц (и векторов) одного размера n
+// в раскладке "структура массивов": элемент (i, j) всех матриц пакета
+// хранится подряд - в строке из Stride элементов (count, округленное до
+// строки кэша), строки элементов идут в порядке упаковки TMatrix. Операции
+// над пакетом выполняют внутренний цикл по матрицам пакета, поэтому он
+// векторизуется независимо от n; пакет делится на блоки по BATCH_BLOCK
+// матриц, блоки раздаются потокам пула (utparallel.h).
+
+#ifndef __UTBATCH_H__
+#define __UTBATCH_H__
+
+#include <algorithm>
+#include <iostream>
+#include "utmatrix.h"
+
+using namespace std;
+
+const int BATCH_BLOCK = 256; // матриц в блоке: строки элементов блока - в кэше L2
+
+// Длина строки элементов для count матриц: кратна строке кэша
+template <class ValType>
+int BatchStride(int count)
+{
+	const int al = max(1, int(MATRIX_ALIGNMENT / sizeof(ValType)));
+	return (count + al - 1) / al * al;
+} /*-------------------------------------------------------------------------*/
+
+// Выполнить f(b0, b1) над блоками матриц [b0, b1) длины не более BATCH_BLOCK;
+// блоки раздаются потокам пула, если общий объем работы work не меньше порога
+template <class F>
+void BatchRange(int count, long long work, F f)
+{
+	int blocks = (count + BATCH_BLOCK - 1) / BATCH_BLOCK;
+	if (blocks == 0)
+		return;
+	int tasks = min(blocks, GetNumThreads()), chunk = (blocks + tasks - 1) / tasks;
+	ParallelTasks(tasks, work, [&](int t)
+	{
+		for (int k = t * chunk; k < min(blocks, (t + 1) * chunk); k++)
+			f(k * BATCH_BLOCK, min(count, (k + 1) * BATCH_BLOCK));
+	});
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> class TMatrixBatch;
+
+// Пакет векторов: компонента k всех векторов - строка из Stride элементов
+template <class ValType>
+class TVectorBatch
+{
+protected:
+	ValType *pElem;
+	int Size;   // размер векторов
+	int Count;  // число векторов
+	int Stride; // длина строки компоненты
+
+	size_t Index(int b, int k) const; // номер компоненты k вектора b в pElem
+	friend class TMatrixBatch<ValType>;
+public:
+	TVectorBatch(int s = 10, int count = 1);
+	TVectorBatch(const TVectorBatch &vb);
+	TVectorBatch(TVectorBatch &&vb) noexcept;
+	~TVectorBatch() { FreeAligned(pElem, size_t(Size) * Stride); }
+	int GetSize() const { return Size; }
+	int GetCount() const { return Count; }
+	int GetStride() const { return Stride; }
+	ValType* GetLanes(int k) { return pElem + size_t(k) * Stride; } // компонента k
+	const ValType* GetLanes(int k) const { return pElem + size_t(k) * Stride; } // всех векторов
+	ValType& operator()(int b, int k);              // компонента k вектора b
+	const ValType& operator()(int b, int k) const;
+	TVector<ValType> Get(int b) const;              // вектор b
+	void Set(int b, const TVector<ValType> &v);
+	bool operator==(const TVectorBatch &vb) const;
+	bool operator!=(const TVectorBatch &vb) const { return !(*this == vb); }
+	TVectorBatch& operator=(const TVectorBatch &vb);
+	TVectorBatch& operator=(TVectorBatch &&vb) noexcept;
+};
+
+// Пакет матриц
+template <class ValType>
+class TMatrixBatch
+{
+protected:
+	ValType *pElem;
+	int Size;   // размер матриц
+	int Count;  // число матриц
+	int Stride; // длина строки элемента
+
+	int Index(int i, int j) const { return i * Size - i * (i - 1) / 2 + j - i; } // номер
+	                           // элемента (i, j) в упаковке TMatrix
+	size_t Index(int b, int i, int j) const; // номер элемента (i, j) матрицы b в pElem
+	template <class Op>
+	TMatrixBatch& Combine(const TMatrixBatch &mb, Op op); // *this = op(*this, mb)
+public:
+	TMatrixBatch(int s = 10, int count = 1);
+	TMatrixBatch(const TMatrixBatch &mb);
+	TMatrixBatch(TMatrixBatch &&mb) noexcept;
+	~TMatrixBatch() { FreeAligned(pElem, size_t(GetPackedSize()) * Stride); }
+	int GetSize() const { return Size; }
+	int GetCount() const { return Count; }
+	int GetStride() const { return Stride; }
+	int GetPackedSize() const { return Size * (Size + 1) / 2; } // элементов в матрице
+	ValType* GetLanes(int i, int j) { return pElem + size_t(Index(i, j)) * Stride; } // элемент
+	const ValType* GetLanes(int i, int j) const { return pElem + size_t(Index(i, j)) * Stride; }
+	ValType& operator()(int b, int i, int j);       // элемент (i, j) матрицы b
+	const ValType& operator()(int b, int i, int j) const;
+	TMatrix<ValType> Get(int b) const;              // матрица b
+	void Set(int b, const TMatrix<ValType> &mt);
+	bool operator==(const TMatrixBatch &mb) const;
+	bool operator!=(const TMatrixBatch &mb) const { return !(*this == mb); }
+	TMatrixBatch& operator=(const TMatrixBatch &mb);
+	TMatrixBatch& operator=(TMatrixBatch &&mb) noexcept;
+
+	                                                // операции над каждой матрицей пакета
+	TMatrixBatch operator+(const TMatrixBatch &mb) const { return TMatrixBatch(*this) += mb; }
+	TMatrixBatch operator-(const TMatrixBatch &mb) const { return TMatrixBatch(*this) -= mb; }
+	TMatrixBatch& operator+=(const TMatrixBatch &mb);
+	TMatrixBatch& operator-=(const TMatrixBatch &mb);
+	TMatrixBatch& operator*=(const ValType &val);
+	TMatrixBatch operator*(const TMatrixBatch &mb) const;              // умножение
+	TMatrixBatch& MulAdd(const TMatrixBatch &a, const TMatrixBatch &b); // *this += a * b
+	TVectorBatch<ValType> operator*(const TVectorBatch<ValType> &vb) const; // на вектор
+	TVectorBatch<ValType> Solve(const TVectorBatch<ValType> &vb) const; // решение Ux = b
+
+	friend ostream& operator<<(ostream &out, const TMatrixBatch &mb)
+	{
+		for (int b = 0; b < mb.Count; b++)
+			out << mb.Get(b) << '\n'; // матрицы в формате TMatrix через пустую строку
+		return out;
+	}
+};
+
+template <class ValType>
+TVectorBatch<ValType>::TVectorBatch(int s, int count)
+{
+	if ((s > MAX_VECTOR_SIZE) || (s < 0) || (count < 0))
+		throw "Negative size";
+	Size = s;
+	Count = count;
+	Stride = BatchStride<ValType>(count);
+	pElem = AllocAligned<ValType>(size_t(Size) * Stride);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // конструктор копирования
+TVectorBatch<ValType>::TVectorBatch(const TVectorBatch<ValType> &vb) : TVectorBatch(vb.Size, vb.Count)
+{
+	copy_n(vb.pElem, size_t(Size) * Stride, pElem);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещение
+TVectorBatch<ValType>::TVectorBatch(TVectorBatch<ValType> &&vb) noexcept :
+	pElem(vb.pElem), Size(vb.Size), Count(vb.Count), Stride(vb.Stride)
+{
+	vb.pElem = nullptr;
+	vb.Size = vb.Count = vb.Stride = 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // номер компоненты k вектора b (см. UTMATRIX_BOUNDS_CHECK)
+size_t TVectorBatch<ValType>::Index(int b, int k) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((b < 0) || (b >= Count) || (k < 0) || (k >= Size))
+		throw "Index out of range";
+#endif
+	return size_t(k) * Stride + b;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ
+ValType& TVectorBatch<ValType>::operator()(int b, int k)
+{
+	return pElem[Index(b, k)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ к константному пакету
+const ValType& TVectorBatch<ValType>::operator()(int b, int k) const
+{
+	return pElem[Index(b, k)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // вектор b
+TVector<ValType> TVectorBatch<ValType>::Get(int b) const
+{
+	if ((b < 0) || (b >= Count))
+		throw "Index out of range";
+	TVector<ValType> v(Size);
+	for (int k = 0; k < Size; k++)
+		v.GetData()[k] = GetLanes(k)[b];
+	return v;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // записать вектор b
+void TVectorBatch<ValType>::Set(int b, const TVector<ValType> &v)
+{
+	if ((b < 0) || (b >= Count))
+		throw "Index out of range";
+	if (v.GetSize() != Size)
+		throw "Error";
+	for (int k = 0; k < Size; k++)
+		GetLanes(k)[b] = v.GetData()[k];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сравнение
+bool TVectorBatch<ValType>::operator==(const TVectorBatch<ValType> &vb) const
+{
+	if ((Size != vb.Size) || (Count != vb.Count))
+		return false;
+	for (int k = 0; k < Size; k++)
+		if (!equal(GetLanes(k), GetLanes(k) + Count, vb.GetLanes(k)))
+			return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // присваивание
+TVectorBatch<ValType>& TVectorBatch<ValType>::operator=(const TVectorBatch<ValType> &vb)
+{
+	if (this != &vb)
+	{
+		TVectorBatch t(vb);
+		*this = move(t);
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещающее присваивание
+TVectorBatch<ValType>& TVectorBatch<ValType>::operator=(TVectorBatch<ValType> &&vb) noexcept
+{
+	swap(pElem, vb.pElem);
+	swap(Size, vb.Size);
+	swap(Count, vb.Count);
+	swap(Stride, vb.Stride);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TMatrixBatch<ValType>::TMatrixBatch(int s, int count)
+{
+	if ((s > MAX_MATRIX_SIZE) || (s < 0) || (count < 0))
+		throw "Negative size";
+	Size = s;
+	Count = count;
+	Stride = BatchStride<ValType>(count);
+	pElem = AllocAligned<ValType>(size_t(GetPackedSize()) * Stride);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // конструктор копирования
+TMatrixBatch<ValType>::TMatrixBatch(const TMatrixBatch<ValType> &mb) : TMatrixBatch(mb.Size, mb.Count)
+{
+	copy_n(mb.pElem, size_t(GetPackedSize()) * Stride, pElem);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещение
+TMatrixBatch<ValType>::TMatrixBatch(TMatrixBatch<ValType> &&mb) noexcept :
+	pElem(mb.pElem), Size(mb.Size), Count(mb.Count), Stride(mb.Stride)
+{
+	mb.pElem = nullptr;
+	mb.Size = mb.Count = mb.Stride = 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // номер элемента (i, j) матрицы b (см. UTMATRIX_BOUNDS_CHECK)
+size_t TMatrixBatch<ValType>::Index(int b, int i, int j) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((b < 0) || (b >= Count) || (i < 0) || (j < i) || (j >= Size))
+		throw "Index out of range";
+#endif
+	return size_t(Index(i, j)) * Stride + b;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ
+ValType& TMatrixBatch<ValType>::operator()(int b, int i, int j)
+{
+	return pElem[Index(b, i, j)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ к константному пакету
+const ValType& TMatrixBatch<ValType>::operator()(int b, int i, int j) const
+{
+	return pElem[Index(b, i, j)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // матрица b
+TMatrix<ValType> TMatrixBatch<ValType>::Get(int b) const
+{
+	if ((b < 0) || (b >= Count))
+		throw "Index out of range";
+	TMatrix<ValType> mt(Size);
+	for (int e = 0; e < GetPackedSize(); e++) // упаковка TMatrix - та же
+		mt.GetData()[e] = pElem[size_t(e) * Stride + b];
+	return mt;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // записать матрицу b
+void TMatrixBatch<ValType>::Set(int b, const TMatrix<ValType> &mt)
+{
+	if ((b < 0) || (b >= Count))
+		throw "Index out of range";
+	if (mt.GetSize() != Size)
+		throw "Error";
+	for (int e = 0; e < GetPackedSize(); e++)
+		pElem[size_t(e) * Stride + b] = mt.GetData()[e];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сравнение
+bool TMatrixBatch<ValType>::operator==(const TMatrixBatch<ValType> &mb) const
+{
+	if ((Size != mb.Size) || (Count != mb.Count))
+		return false;
+	for (size_t e = 0; e < size_t(GetPackedSize()); e++)
+		if (!equal(pElem + e * Stride, pElem + e * Stride + Count, mb.pElem + e * Stride))
+			return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // присваивание
+TMatrixBatch<ValType>& TMatrixBatch<ValType>::operator=(const TMatrixBatch<ValType> &mb)
+{
+	if (this != &mb)
+	{
+		TMatrixBatch t(mb);
+		*this = move(t);
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещающее присваивание
+TMatrixBatch<ValType>& TMatrixBatch<ValType>::operator=(TMatrixBatch<ValType> &&mb) noexcept
+{
+	swap(pElem, mb.pElem);
+	swap(Size, mb.Size);
+	swap(Count, mb.Count);
+	swap(Stride, mb.Stride);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class Op> // поэлементная операция
+TMatrixBatch<ValType>& TMatrixBatch<ValType>::Combine(const TMatrixBatch<ValType> &mb, Op op)
+{
+	if ((Size != mb.Size) || (Count != mb.Count))
+		throw "Error";
+	BatchRange(Count, (long long)GetPackedSize() * Count, [&](int b0, int b1)
+	{
+		for (size_t e = 0; e < size_t(GetPackedSize()); e++)
+		{
+			ValType *c = pElem + e * Stride;
+			const ValType *a = mb.pElem + e * Stride;
+			for (int b = b0; b < b1; b++)
+				c[b] = op(c[b], a[b]);
+		}
+	});
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сложение на месте
+TMatrixBatch<ValType>& TMatrixBatch<ValType>::operator+=(const TMatrixBatch<ValType> &mb)
+{
+	return Combine(mb, [](const ValType &x, const ValType &y) { return x + y; });
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // вычитание на месте
+TMatrixBatch<ValType>& TMatrixBatch<ValType>::operator-=(const TMatrixBatch<ValType> &mb)
+{
+	return Combine(mb, [](const ValType &x, const ValType &y) { return x - y; });
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение на скаляр на месте
+TMatrixBatch<ValType>& TMatrixBatch<ValType>::operator*=(const ValType &val)
+{
+	return Combine(*this, [&](const ValType &x, const ValType &) { return x * val; });
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение
+TMatrixBatch<ValType> TMatrixBatch<ValType>::operator*(const TMatrixBatch<ValType> &mb) const
+{
+	TMatrixBatch r(Size, Count);
+	fill_n(r.pElem, size_t(GetPackedSize()) * Stride, ValType(0));
+	r.MulAdd(*this, mb);
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+// Умножение с накоплением без выделения памяти:
+// c(i, j) += sum a(i, k) b(k, j), k = i..j
+template <class ValType>
+TMatrixBatch<ValType>& TMatrixBatch<ValType>::MulAdd(const TMatrixBatch<ValType> &a,
+	const TMatrixBatch<ValType> &b)
+{
+	if ((Size != a.Size) || (Count != a.Count) || (Size != b.Size) || (Count != b.Count))
+		throw "Error";
+	if ((this == &a) || (this == &b))
+		throw "Error"; // результат не может быть сомножителем
+	long long n = Size;
+	BatchRange(Count, n * (n + 1) * (n + 2) / 6 * Count, [&](int b0, int b1)
+	{
+		for (int i = 0; i < Size; i++)
+			for (int j = i; j < Size; j++)
+			{
+				ValType *c = GetLanes(i, j);
+				for (int k = i; k <= j; k++)
+				{
+					const ValType *x = a.GetLanes(i, k), *y = b.GetLanes(k, j);
+					for (int l = b0; l < b1; l++)
+						c[l] = c[l] + x[l] * y[l];
+				}
+			}
+	});
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение на вектор: y(i) = sum a(i, j) x(j), j = i..n-1
+TVectorBatch<ValType> TMatrixBatch<ValType>::operator*(const TVectorBatch<ValType> &vb) const
+{
+	if ((Size != vb.Size) || (Count != vb.Count))
+		throw "Error";
+	TVectorBatch<ValType> r(Size, Count);
+	fill_n(r.pElem, size_t(Size) * Stride, ValType(0));
+	BatchRange(Count, (long long)GetPackedSize() * Count, [&](int b0, int b1)
+	{
+		for (int i = 0; i < Size; i++)
+		{
+			ValType *y = r.GetLanes(i);
+			for (int j = i; j < Size; j++)
+			{
+				const ValType *a = GetLanes(i, j), *x = vb.GetLanes(j);
+				for (int b = b0; b < b1; b++)
+					y[b] = y[b] + a[b] * x[b];
+			}
+		}
+	});
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+// Решение Ux = b обратной подстановкой для каждой матрицы пакета; вырожденность
+// проверяется до решения, поэтому при исключении части пакета не решаются
+template <class ValType>
+TVectorBatch<ValType> TMatrixBatch<ValType>::Solve(const TVectorBatch<ValType> &vb) const
+{
+	if ((Size != vb.Size) || (Count != vb.Count))
+		throw "Error";
+	for (int i = 0; i < Size; i++)
+	{
+		const ValType *d = GetLanes(i, i);
+		if (find(d, d + Count, ValType(0)) != d + Count)
+			throw "Singular matrix";
+	}
+	TVectorBatch<ValType> r(vb);
+	BatchRange(Count, (long long)GetPackedSize() * Count, [&](int b0, int b1)
+	{
+		for (int i = Size - 1; i >= 0; i--)
+		{
+			ValType *x = r.GetLanes(i);
+			for (int j = i + 1; j < Size; j++)
+			{
+				const ValType *a = GetLanes(i, j), *y = r.GetLanes(j);
+				for (int b = b0; b < b1; b++)
+					x[b] = x[b] - a[b] * y[b];
+			}
+			const ValType *d = GetLanes(i, i);
+			for (int b = b0; b < b1; b++)
+				x[b] = x[b] / d[b];
+		}
+	});
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+#endif
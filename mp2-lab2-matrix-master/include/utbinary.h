@@ -0,0 +1,438 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utbinary.h
+//
+// Двоичный формат векторов и матриц. Файл - заголовок TBinaryHeader
+// (64 байта) и данные: элементы вектора или упакованный треугольник
+// матрицы по строкам, как в TMatrix::GetData. Данные записываются в порядке
+// байт записавшей машины, поле ByteOrder позволяет прочитать файл на машине
+// с другим порядком. Контрольная сумма покрывает заголовок и данные.
+// TMappedMatrix/TMappedVector отображают файл в память без копирования:
+// страницы читаются с диска при первом обращении к ним.
+
+#ifndef __UTBINARY_H__
+#define __UTBINARY_H__
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include "utmatrix.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+const uint16_t BINARY_VERSION = 1;
+const uint16_t BINARY_BYTE_ORDER = 0x0102; // в файле с другим порядком байт читается как 0x0201
+const int BINARY_VECTOR = 1;               // вид объекта в заголовке
+const int BINARY_MATRIX = 2;
+
+struct TBinaryHeader
+{
+	char Magic[4];        // "UTMX"
+	uint16_t ByteOrder;   // BINARY_BYTE_ORDER в порядке байт записавшей машины
+	uint16_t Version;     // BINARY_VERSION
+	uint8_t Kind;         // BINARY_VECTOR или BINARY_MATRIX
+	uint8_t ElemType;     // код типа элемента (TBinaryType)
+	uint16_t ElemSize;    // размер элемента (байт)
+	uint32_t Reserved;
+	int64_t Size;         // размер вектора или матрицы
+	int64_t StartIndex;   // индекс первого элемента вектора
+	uint64_t Count;       // число элементов данных
+	uint64_t DataOffset;  // начало данных от начала файла
+	uint64_t Checksum;    // BinaryChecksum заголовка (с нулевым Checksum) и данных
+	uint8_t Pad[8];
+};
+static_assert(sizeof(TBinaryHeader) == 64, "TBinaryHeader must be 64 bytes");
+
+// Код типа элемента: 1..8 - целые со знаком и без по размеру 1, 2, 4, 8 байт,
+// 9 - float, 10 - double, 0 - тип не поддерживается
+template <class T>
+struct TBinaryType
+{
+	static constexpr int Log2Size = (sizeof(T) == 1) ? 0 : (sizeof(T) == 2) ? 1 :
+		(sizeof(T) == 4) ? 2 : (sizeof(T) == 8) ? 3 : -1;
+	static constexpr int Code = is_same<T, bool>::value ? 0 :
+		is_integral<T>::value ? ((Log2Size < 0) ? 0 : 1 + 2 * Log2Size + (is_unsigned<T>::value ? 1 : 0)) :
+		is_same<T, float>::value ? 9 : is_same<T, double>::value ? 10 : 0;
+};
+
+  // Вспомогательные функции
+
+inline bool IsLittleEndian()
+{
+	const uint16_t one = 1;
+	unsigned char b;
+	memcpy(&b, &one, 1);
+	return b == 1;
+} /*-------------------------------------------------------------------------*/
+
+// Обратить порядок байт каждого из count элементов по size байт
+inline void SwapBytes(void *data, size_t size, size_t count)
+{
+	unsigned char *p = static_cast<unsigned char*>(data);
+	for (size_t k = 0; k < count; k++, p += size)
+		for (size_t i = 0; i < size / 2; i++)
+			swap(p[i], p[size - 1 - i]);
+} /*-------------------------------------------------------------------------*/
+
+inline uint64_t RotateLeft(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+} /*-------------------------------------------------------------------------*/
+
+// 64-битная контрольная сумма bytes байт; слова читаются как little-endian,
+// поэтому сумма не зависит от машины. Четыре независимые цепочки по 8 байт
+// позволяют обрабатывать несколько гигабайт в секунду
+inline uint64_t BinaryChecksum(const void *data, size_t bytes, uint64_t seed = 0)
+{
+	const uint64_t P1 = 0x9E3779B185EBCA87ULL, P2 = 0xC2B2AE3D27D4EB4FULL;
+	const unsigned char *p = static_cast<const unsigned char*>(data);
+	const bool little = IsLittleEndian();
+	uint64_t h[4] = { seed + P1, seed + P2, seed, seed - P1 };
+	size_t k = 0;
+	for (; k + 32 <= bytes; k += 32)
+		for (int l = 0; l < 4; l++)
+		{
+			uint64_t w;
+			memcpy(&w, p + k + 8 * l, 8);
+			if (!little)
+				SwapBytes(&w, 8, 1);
+			h[l] = RotateLeft(h[l] + w * P2, 31) * P1;
+		}
+	uint64_t r = RotateLeft(h[0], 1) + RotateLeft(h[1], 7) + RotateLeft(h[2], 12) +
+		RotateLeft(h[3], 18) + uint64_t(bytes);
+	for (; k < bytes; k++)
+		r = RotateLeft(r ^ (p[k] * P1), 11) * P2;
+	r ^= r >> 33;
+	r *= P2;
+	r ^= r >> 29;
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+// Заголовок для объекта вида kind из count элементов типа T
+template <class T>
+TBinaryHeader MakeBinaryHeader(int kind, int size, int si, size_t count)
+{
+	TBinaryHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.Magic, "UTMX", 4);
+	h.ByteOrder = BINARY_BYTE_ORDER;
+	h.Version = BINARY_VERSION;
+	h.Kind = uint8_t(kind);
+	h.ElemType = uint8_t(TBinaryType<T>::Code);
+	h.ElemSize = uint16_t(sizeof(T));
+	h.Size = size;
+	h.StartIndex = si;
+	h.Count = count;
+	h.DataOffset = sizeof(TBinaryHeader);
+	return h;
+} /*-------------------------------------------------------------------------*/
+
+// Заголовок в порядке байт этой машины; swapped - файл записан с другим
+// порядком, seed - контрольная сумма заголовка в том виде, как он записан
+inline TBinaryHeader DecodeBinaryHeader(const void *raw, bool &swapped, uint64_t &seed)
+{
+	TBinaryHeader h;
+	memcpy(&h, raw, sizeof(h));
+	if (memcmp(h.Magic, "UTMX", 4) != 0)
+		throw "Bad format";
+	TBinaryHeader z = h;
+	z.Checksum = 0;
+	seed = BinaryChecksum(&z, sizeof(z));
+	swapped = (h.ByteOrder != BINARY_BYTE_ORDER);
+	if (swapped)
+	{
+		SwapBytes(&h.ByteOrder, 2, 1);
+		SwapBytes(&h.Version, 2, 1);
+		SwapBytes(&h.ElemSize, 2, 1);
+		SwapBytes(&h.Size, 8, 1);
+		SwapBytes(&h.StartIndex, 8, 1);
+		SwapBytes(&h.Count, 8, 1);
+		SwapBytes(&h.DataOffset, 8, 1);
+		SwapBytes(&h.Checksum, 8, 1);
+		if (h.ByteOrder != BINARY_BYTE_ORDER)
+			throw "Bad format";
+	}
+	if ((h.Version == 0) || (h.Version > BINARY_VERSION))
+		throw "Unsupported version";
+	if (h.DataOffset < sizeof(TBinaryHeader))
+		throw "Bad format";
+	return h;
+} /*-------------------------------------------------------------------------*/
+
+// Проверить, что заголовок описывает объект вида kind с элементами типа T
+template <class T>
+void CheckBinaryHeader(const TBinaryHeader &h, int kind)
+{
+	if ((h.Kind != kind) || (h.ElemType != TBinaryType<T>::Code) || (h.ElemSize != sizeof(T)))
+		throw "Type mismatch";
+	if (kind == BINARY_MATRIX)
+	{
+		if ((h.Size < 0) || (h.Size > MAX_MATRIX_SIZE) ||
+			(h.Count != uint64_t(h.Size) * uint64_t(h.Size + 1) / 2))
+			throw "Bad format";
+	}
+	else if ((h.Size < 0) || (h.Size > MAX_VECTOR_SIZE) || (h.StartIndex < 0) ||
+		(h.StartIndex > MAX_VECTOR_SIZE) || (h.Count != uint64_t(h.Size)))
+		throw "Bad format";
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void WriteBinaryData(ostream &out, TBinaryHeader h, const T *data)
+{
+	static_assert(TBinaryType<T>::Code != 0, "unsupported element type");
+	size_t bytes = size_t(h.Count) * sizeof(T);
+	h.Checksum = BinaryChecksum(data, bytes, BinaryChecksum(&h, sizeof(h)));
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(reinterpret_cast<const char*>(data), streamsize(bytes));
+	if (!out)
+		throw "Write error";
+} /*-------------------------------------------------------------------------*/
+
+// Прочитать заголовок объекта вида kind; data(h) возвращает буфер для данных
+template <class T, class F>
+void ReadBinaryData(istream &in, int kind, F data)
+{
+	static_assert(TBinaryType<T>::Code != 0, "unsupported element type");
+	char raw[sizeof(TBinaryHeader)];
+	if (!in.read(raw, sizeof(raw)))
+		throw "Bad format";
+	bool swapped;
+	uint64_t seed;
+	TBinaryHeader h = DecodeBinaryHeader(raw, swapped, seed);
+	CheckBinaryHeader<T>(h, kind);
+	in.ignore(streamsize(h.DataOffset - sizeof(TBinaryHeader)));
+	T *p = data(h);
+	size_t bytes = size_t(h.Count) * sizeof(T);
+	if (!in.read(reinterpret_cast<char*>(p), streamsize(bytes)))
+		throw "Bad format";
+	if (BinaryChecksum(p, bytes, seed) != h.Checksum)
+		throw "Checksum mismatch";
+	if (swapped)
+		SwapBytes(p, sizeof(T), size_t(h.Count));
+} /*-------------------------------------------------------------------------*/
+
+  // Запись и чтение потоков (поток должен быть открыт в режиме ios::binary)
+
+template <class ValType>
+void WriteBinary(ostream &out, const TVector<ValType> &v)
+{
+	WriteBinaryData(out, MakeBinaryHeader<ValType>(BINARY_VECTOR, v.GetSize(),
+		v.GetStartIndex(), v.GetSize()), v.GetData());
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void WriteBinary(ostream &out, const TMatrix<ValType> &mt)
+{
+	WriteBinaryData(out, MakeBinaryHeader<ValType>(BINARY_MATRIX, mt.GetSize(), 0,
+		mt.GetPackedSize()), mt.GetData());
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void ReadBinary(istream &in, TVector<ValType> &v)
+{
+	TVector<ValType> tmp(0);
+	ReadBinaryData<ValType>(in, BINARY_VECTOR, [&](const TBinaryHeader &h)
+	{
+		tmp = TVector<ValType>(int(h.Size), int(h.StartIndex));
+		return tmp.GetData();
+	});
+	v = move(tmp);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void ReadBinary(istream &in, TMatrix<ValType> &mt)
+{
+	TMatrix<ValType> tmp(0);
+	ReadBinaryData<ValType>(in, BINARY_MATRIX, [&](const TBinaryHeader &h)
+	{
+		tmp = TMatrix<ValType>(int(h.Size));
+		return tmp.GetData();
+	});
+	mt = move(tmp);
+} /*-------------------------------------------------------------------------*/
+
+  // Запись и чтение файлов
+
+template <class X>
+void SaveBinary(const string &fileName, const X &x)
+{
+	ofstream out(fileName.c_str(), ios::binary | ios::trunc);
+	if (!out)
+		throw "Cannot open file";
+	WriteBinary(out, x);
+	out.close();
+	if (!out)
+		throw "Write error";
+} /*-------------------------------------------------------------------------*/
+
+template <class X>
+void LoadBinary(const string &fileName, X &x)
+{
+	ifstream in(fileName.c_str(), ios::binary);
+	if (!in)
+		throw "Cannot open file";
+	ReadBinary(in, x);
+} /*-------------------------------------------------------------------------*/
+
+  // Отображение файла в память (только чтение)
+
+class TMappedFile
+{
+	const unsigned char *pData;
+	size_t Length;
+public:
+	explicit TMappedFile(const string &fileName);
+	~TMappedFile();
+	TMappedFile(const TMappedFile&) = delete;
+	TMappedFile& operator=(const TMappedFile&) = delete;
+	const unsigned char* GetData() const { return pData; }
+	size_t GetLength() const { return Length; }
+};
+
+#ifdef _WIN32
+inline TMappedFile::TMappedFile(const string &fileName) : pData(nullptr), Length(0)
+{
+	HANDLE f = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (f == INVALID_HANDLE_VALUE)
+		throw "Cannot open file";
+	LARGE_INTEGER len;
+	HANDLE m = NULL;
+	if (GetFileSizeEx(f, &len) && (len.QuadPart > 0))
+		m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(f);
+	if (m == NULL)
+		throw "Cannot map file";
+	pData = static_cast<const unsigned char*>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(m); // отображение живет, пока открыт вид
+	if (pData == nullptr)
+		throw "Cannot map file";
+	Length = size_t(len.QuadPart);
+} /*-------------------------------------------------------------------------*/
+
+inline TMappedFile::~TMappedFile()
+{
+	UnmapViewOfFile(pData);
+} /*-------------------------------------------------------------------------*/
+#else
+inline TMappedFile::TMappedFile(const string &fileName) : pData(nullptr), Length(0)
+{
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw "Cannot open file";
+	struct stat st;
+	void *p = MAP_FAILED;
+	if ((fstat(fd, &st) == 0) && (st.st_size > 0))
+		p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // отображение остается после закрытия файла
+	if (p == MAP_FAILED)
+		throw "Cannot map file";
+	pData = static_cast<const unsigned char*>(p);
+	Length = size_t(st.st_size);
+} /*-------------------------------------------------------------------------*/
+
+inline TMappedFile::~TMappedFile()
+{
+	munmap(const_cast<unsigned char*>(pData), Length);
+} /*-------------------------------------------------------------------------*/
+#endif
+
+// Заголовок отображенного файла с данными вида kind; данные должны быть
+// записаны с порядком байт этой машины и выровнены для T
+template <class T>
+TBinaryHeader MapBinaryHeader(const TMappedFile &f, int kind, uint64_t &seed)
+{
+	static_assert(TBinaryType<T>::Code != 0, "unsupported element type");
+	if (f.GetLength() < sizeof(TBinaryHeader))
+		throw "Bad format";
+	bool swapped;
+	TBinaryHeader h = DecodeBinaryHeader(f.GetData(), swapped, seed);
+	CheckBinaryHeader<T>(h, kind);
+	if (swapped) // без копирования можно читать только родной порядок байт
+		throw "Foreign byte order";
+	if ((h.DataOffset % alignof(T) != 0) || (h.DataOffset > f.GetLength()) ||
+		(h.Count > (f.GetLength() - h.DataOffset) / sizeof(T))) // без переполнения
+		throw "Bad format";
+	return h;
+} /*-------------------------------------------------------------------------*/
+
+// Матрица из двоичного файла без копирования данных. Доступ только на
+// чтение через Get(); все операции TMatrix, включая ядра умножения и
+// решения систем, работают прямо с отображенной памятью. Контрольная
+// сумма по умолчанию не проверяется, так как требует чтения всего файла
+template <class ValType>
+class TMappedMatrix
+{
+	TMappedFile File;
+	TBinaryHeader Header;
+	uint64_t Seed;
+	TMatrix<ValType> Matrix; // представление над данными файла
+public:
+	explicit TMappedMatrix(const string &fileName, bool verify = false);
+	const TMatrix<ValType>& Get() const { return Matrix; }
+	bool Verify() const;     // совпадает ли контрольная сумма
+};
+
+template <class ValType>
+TMappedMatrix<ValType>::TMappedMatrix(const string &fileName, bool verify) :
+	File(fileName), Header(MapBinaryHeader<ValType>(File, BINARY_MATRIX, Seed)),
+	Matrix(reinterpret_cast<ValType*>(const_cast<unsigned char*>(File.GetData() + Header.DataOffset)),
+		int(Header.Size))
+{
+	if (verify && !Verify())
+		throw "Checksum mismatch";
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+bool TMappedMatrix<ValType>::Verify() const
+{
+	return BinaryChecksum(File.GetData() + Header.DataOffset,
+		size_t(Header.Count) * sizeof(ValType), Seed) == Header.Checksum;
+} /*-------------------------------------------------------------------------*/
+
+// Вектор из двоичного файла без копирования данных (см. TMappedMatrix)
+template <class ValType>
+class TMappedVector
+{
+	TMappedFile File;
+	TBinaryHeader Header;
+	uint64_t Seed;
+	TVector<ValType> Vector; // представление над данными файла
+public:
+	explicit TMappedVector(const string &fileName, bool verify = false);
+	const TVector<ValType>& Get() const { return Vector; }
+	bool Verify() const;
+};
+
+template <class ValType>
+TMappedVector<ValType>::TMappedVector(const string &fileName, bool verify) :
+	File(fileName), Header(MapBinaryHeader<ValType>(File, BINARY_VECTOR, Seed)),
+	Vector(reinterpret_cast<ValType*>(const_cast<unsigned char*>(File.GetData() + Header.DataOffset)),
+		int(Header.Size), int(Header.StartIndex))
+{
+	if (verify && !Verify())
+		throw "Checksum mismatch";
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+bool TMappedVector<ValType>::Verify() const
+{
+	return BinaryChecksum(File.GetData() + Header.DataOffset,
+		size_t(Header.Count) * sizeof(ValType), Seed) == Header.Checksum;
+} /*-------------------------------------------------------------------------*/
+
+#endif
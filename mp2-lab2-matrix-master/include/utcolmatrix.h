@@ -0,0 +1,229 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utcolmatrix.h
+//
+// Верхнетреугольная матрица с упаковкой по столбцам: столбец j (элементы
+// строк 0..j) хранится подряд с позиции j(j+1)/2, поэтому элемент (i, j)
+// находится в pElem[j(j+1)/2 + i]. Увеличение размера с n до n+1 добавляет
+// в конец буфера один столбец из n+1 элементов, а не перестраивает все
+// строки, как в TMatrix. Буфер растет геометрически (вдвое), поэтому
+// добавление измерения в среднем стоит O(n). Доступ к элементам - как
+// у TMatrix: mt[i][j], j >= i.
+
+#ifndef __UTCOLMATRIX_H__
+#define __UTCOLMATRIX_H__
+
+#include <algorithm>
+#include <iostream>
+#include "utmatrix.h"
+
+using namespace std;
+
+// Строка i матрицы TColMatrix: элементы строки лежат в разных столбцах,
+// поэтому строка - не вектор, а ссылка на матрицу (T - ValType или const ValType)
+template <class T>
+class TColRow
+{
+	T *pElem;
+	int Row;  // номер строки
+	int Size; // размер матрицы
+public:
+	TColRow(T *p, int i, int s) : pElem(p), Row(i), Size(s) {}
+	int GetSize() const { return Size - Row; }  // число хранимых элементов
+	int GetStartIndex() const { return Row; }   // индекс первого элемента
+	T& operator[](int j) const                  // доступ (см. UTMATRIX_BOUNDS_CHECK)
+	{
+#if UTMATRIX_BOUNDS_CHECK
+		if ((j < Row) || (j >= Size))
+			throw "Index out of range";
+#endif
+		return pElem[j * (j + 1) / 2 + Row];
+	}
+	T& at_unchecked(int j) const { return pElem[j * (j + 1) / 2 + Row]; } // без проверки
+};
+
+// Шаблон матрицы с упаковкой по столбцам
+template <class ValType>
+class TColMatrix
+{
+protected:
+	ValType *pElem;
+	int Size;     // размер матрицы
+	int Capacity; // число элементов, под которые выделен буфер
+
+	void Grow(int count); // буфер не менее чем на count элементов
+public:
+	TColMatrix(int s = 10); // нулевая матрица
+	explicit TColMatrix(const TMatrix<ValType> &mt); // из упаковки по строкам
+	TColMatrix(const TColMatrix &mt);
+	TColMatrix(TColMatrix &&mt) noexcept;
+	~TColMatrix() { FreeAligned(pElem, Capacity); }
+	int GetSize() const { return Size; }
+	int GetCapacity() const { return Capacity; }
+	int GetPackedSize() const { return Size * (Size + 1) / 2; } // число хранимых элементов
+	int GetColOffset(int j) const { return j * (j + 1) / 2; }   // начало столбца j в буфере
+	ValType* GetData() { return pElem; }
+	const ValType* GetData() const { return pElem; }
+	TColRow<ValType> operator[](int pos);             // строка pos
+	TColRow<const ValType> operator[](int pos) const;
+	bool operator==(const TColMatrix &mt) const;
+	bool operator!=(const TColMatrix &mt) const { return !(*this == mt); }
+	TColMatrix& operator=(const TColMatrix &mt);
+	TColMatrix& operator=(TColMatrix &&mt) noexcept;
+	TMatrix<ValType> ToMatrix() const;                // в упаковку по строкам
+
+	void Reserve(int s);    // выделить буфер под размер s без изменения размера
+	void AppendDimension(); // добавить нулевой столбец: размер n -> n + 1
+	void AppendDimension(const TVector<ValType> &col); // добавить столбец
+	                        // col[0..n] - элементы строк 0..n нового столбца
+
+	friend ostream& operator<<(ostream &out, const TColMatrix &mt)
+	{
+		return out << mt.ToMatrix(); // в формате TMatrix
+	}
+};
+
+template <class ValType>
+void TColMatrix<ValType>::Grow(int count)
+{
+	ValType *p = AllocAligned<ValType>(count);
+	move(pElem, pElem + GetPackedSize(), p);
+	FreeAligned(pElem, Capacity);
+	pElem = p;
+	Capacity = count;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TColMatrix<ValType>::TColMatrix(int s)
+{
+	if ((s > MAX_MATRIX_SIZE) || (s < 0))
+		throw "Negative size";
+	Size = s;
+	Capacity = GetPackedSize();
+	pElem = AllocAligned<ValType>(Capacity);
+	fill_n(pElem, Capacity, ValType(0));
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // из упаковки по строкам
+TColMatrix<ValType>::TColMatrix(const TMatrix<ValType> &mt) : TColMatrix(mt.GetSize())
+{
+	for (int i = 0; i < Size; i++)
+	{
+		const ValType *row = mt.GetData() + mt.GetRowOffset(i) - i; // row[j] = mt[i][j]
+		for (int j = i; j < Size; j++)
+			pElem[j * (j + 1) / 2 + i] = row[j];
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // конструктор копирования
+TColMatrix<ValType>::TColMatrix(const TColMatrix<ValType> &mt) : TColMatrix(mt.Size)
+{
+	copy_n(mt.pElem, GetPackedSize(), pElem);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещение
+TColMatrix<ValType>::TColMatrix(TColMatrix<ValType> &&mt) noexcept :
+	pElem(mt.pElem), Size(mt.Size), Capacity(mt.Capacity)
+{
+	mt.pElem = nullptr;
+	mt.Size = 0;
+	mt.Capacity = 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // строка pos
+TColRow<ValType> TColMatrix<ValType>::operator[](int pos)
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < 0) || (pos >= Size))
+		throw "Index out of range";
+#endif
+	return TColRow<ValType>(pElem, pos, Size);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // строка pos константной матрицы
+TColRow<const ValType> TColMatrix<ValType>::operator[](int pos) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < 0) || (pos >= Size))
+		throw "Index out of range";
+#endif
+	return TColRow<const ValType>(pElem, pos, Size);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сравнение
+bool TColMatrix<ValType>::operator==(const TColMatrix<ValType> &mt) const
+{
+	return (Size == mt.Size) && equal(pElem, pElem + GetPackedSize(), mt.pElem);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // присваивание
+TColMatrix<ValType>& TColMatrix<ValType>::operator=(const TColMatrix<ValType> &mt)
+{
+	if (this != &mt)
+	{
+		if (Capacity < mt.GetPackedSize()) // прежний буфер используется, если хватает
+		{
+			ValType *p = AllocAligned<ValType>(mt.GetPackedSize());
+			FreeAligned(pElem, Capacity);
+			pElem = p;
+			Capacity = mt.GetPackedSize();
+		}
+		Size = mt.Size;
+		copy_n(mt.pElem, GetPackedSize(), pElem);
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещающее присваивание
+TColMatrix<ValType>& TColMatrix<ValType>::operator=(TColMatrix<ValType> &&mt) noexcept
+{
+	swap(pElem, mt.pElem);
+	swap(Size, mt.Size);
+	swap(Capacity, mt.Capacity);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // в упаковку по строкам
+TMatrix<ValType> TColMatrix<ValType>::ToMatrix() const
+{
+	TMatrix<ValType> mt(Size);
+	for (int i = 0; i < Size; i++)
+	{
+		ValType *row = mt.GetData() + mt.GetRowOffset(i) - i;
+		for (int j = i; j < Size; j++)
+			row[j] = pElem[j * (j + 1) / 2 + i];
+	}
+	return mt;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // выделить буфер под размер s
+void TColMatrix<ValType>::Reserve(int s)
+{
+	if ((s > MAX_MATRIX_SIZE) || (s < 0))
+		throw "Error";
+	if (s * (s + 1) / 2 > Capacity)
+		Grow(s * (s + 1) / 2);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // добавить нулевой столбец
+void TColMatrix<ValType>::AppendDimension()
+{
+	if (Size >= MAX_MATRIX_SIZE)
+		throw "Error";
+	int count = (Size + 1) * (Size + 2) / 2;
+	if (count > Capacity)
+		Grow(max(count, min(2 * Capacity, MAX_MATRIX_SIZE * (MAX_MATRIX_SIZE + 1) / 2)));
+	fill(pElem + GetPackedSize(), pElem + count, ValType(0));
+	Size++;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // добавить столбец col[0..n]
+void TColMatrix<ValType>::AppendDimension(const TVector<ValType> &col)
+{
+	if (col.GetSize() != Size + 1)
+		throw "Error";
+	AppendDimension();
+	copy_n(col.GetData(), Size, pElem + GetColOffset(Size - 1));
+} /*-------------------------------------------------------------------------*/
+
+#endif
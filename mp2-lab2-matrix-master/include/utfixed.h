@@ -0,0 +1,279 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utfixed.h
+//
+// Верхнетреугольная матрица TMatrix<ValType, N> с размером N, заданным при
+// компиляции, - для малых матриц (3..8, например локальных якобианов).
+// N(N+1)/2 элементов хранятся построчно в самом объекте, без выделения
+// памяти; матрицу можно создать в constexpr-выражении. Сложение, умножение,
+// умножение на вектор и решение системы развертываются при компиляции
+// в линейный код без циклов (индексы элементов - константы). Векторы
+// размера N - std::array<ValType, N>. TMatrix<ValType> (N = 0) - матрица
+// с размером, задаваемым при выполнении (utmatrix.h); доступ m[i][j]
+// у обеих матриц одинаков (j - номер столбца, j >= i).
+
+#ifndef __UTFIXED_H__
+#define __UTFIXED_H__
+
+#include <array>
+#include <initializer_list>
+#include <iostream>
+#include <utility>
+#include "utmatrix.h"
+
+using namespace std;
+
+template <class F, int... K>
+constexpr void UnrollSeq(F &f, integer_sequence<int, K...>)
+{
+	(f(integral_constant<int, K>()), ...);
+} /*-------------------------------------------------------------------------*/
+
+// f(integral_constant<int, K>()) для K = 0..Count-1 без цикла
+template <int Count, class F>
+constexpr void Unroll(F f)
+{
+	UnrollSeq(f, make_integer_sequence<int, Count>());
+} /*-------------------------------------------------------------------------*/
+
+// Строка i матрицы размера N: элементы i..N-1, индекс - номер столбца,
+// как у строки TMatrix<ValType>; ValType = const T - только для чтения
+template <class ValType, int N>
+class TFixedRow
+{
+	ValType *pRow; // элемент (i, i)
+	int Row;
+public:
+	constexpr TFixedRow(ValType *p, int i) : pRow(p), Row(i) {}
+	constexpr int GetSize() const { return N - Row; }
+	constexpr int GetStartIndex() const { return Row; }
+	constexpr ValType& operator[](int j) const // доступ (см. UTMATRIX_BOUNDS_CHECK)
+	{
+#if UTMATRIX_BOUNDS_CHECK
+		if ((j < Row) || (j >= N))
+			throw "Index out of range";
+#endif
+		return pRow[j - Row];
+	}
+};
+
+// Шаблон матрицы размера N
+template <class ValType, int N>
+class TMatrix
+{
+	static_assert((N > 0) && (N <= MAX_MATRIX_SIZE), "TMatrix: bad size");
+public:
+	static constexpr int Count = N * (N + 1) / 2; // число хранимых элементов
+	typedef array<ValType, N> TVec;                // вектор размера N
+protected:
+	ValType Elem[Count];
+
+	static constexpr int Index(int i, int j) { return i * N - i * (i - 1) / 2 + j - i; }
+public:
+	constexpr TMatrix() : Elem{} {}                    // нулевая матрица
+	constexpr TMatrix(initializer_list<ValType> l);    // элементы строк подряд
+	explicit TMatrix(const TMatrix<ValType> &mt);     // из матрицы размера N
+	TMatrix<ValType> ToMatrix() const;
+	static constexpr int GetSize() { return N; }
+	static constexpr int GetPackedSize() { return Count; }
+	static constexpr int GetRowOffset(int i) { return Index(i, i); } // начало строки i
+	ValType* GetData() { return Elem; }
+	const ValType* GetData() const { return Elem; }
+	ValType* begin() { return Elem; }                  // итераторы STL
+	ValType* end() { return Elem + Count; }
+	const ValType* begin() const { return Elem; }
+	const ValType* end() const { return Elem + Count; }
+	constexpr ValType& operator()(int i, int j);       // доступ (см. UTMATRIX_BOUNDS_CHECK)
+	constexpr const ValType& operator()(int i, int j) const;
+	constexpr TFixedRow<ValType, N> operator[](int i);  // строка: m[i][j] = m(i, j)
+	constexpr TFixedRow<const ValType, N> operator[](int i) const;
+	constexpr bool operator==(const TMatrix &mt) const;
+	constexpr bool operator!=(const TMatrix &mt) const { return !(*this == mt); }
+	constexpr TMatrix operator+(const TMatrix &mt) const;
+	constexpr TMatrix operator-(const TMatrix &mt) const;
+	constexpr TMatrix operator*(const ValType &val) const;
+	constexpr TMatrix& operator+=(const TMatrix &mt);
+	constexpr TMatrix& operator-=(const TMatrix &mt);
+	constexpr TMatrix operator*(const TMatrix &mt) const; // умножение
+	constexpr TVec operator*(const TVec &v) const;         // умножение на вектор
+	constexpr TVec Solve(const TVec &b) const;             // решение Ux = b
+
+	friend ostream& operator<<(ostream &out, const TMatrix &mt)
+	{
+		return out << mt.ToMatrix(); // в формате TMatrix<ValType>
+	}
+};
+
+template <class ValType, int N> // элементы строк подряд
+constexpr TMatrix<ValType, N>::TMatrix(initializer_list<ValType> l) : Elem{}
+{
+	if (int(l.size()) != Count)
+		throw "Error";
+	int k = 0;
+	for (const ValType &x : l)
+		Elem[k++] = x;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // из матрицы размера N
+TMatrix<ValType, N>::TMatrix(const TMatrix<ValType> &mt)
+{
+	if (mt.GetSize() != N)
+		throw "Error";
+	copy_n(mt.GetData(), Count, Elem);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // в матрицу с размером при выполнении
+TMatrix<ValType> TMatrix<ValType, N>::ToMatrix() const
+{
+	TMatrix<ValType> mt(N);
+	copy_n(Elem, Count, mt.GetData());
+	return mt;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // доступ
+constexpr ValType& TMatrix<ValType, N>::operator()(int i, int j)
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((i < 0) || (j < i) || (j >= N))
+		throw "Index out of range";
+#endif
+	return Elem[Index(i, j)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // доступ к константной матрице
+constexpr const ValType& TMatrix<ValType, N>::operator()(int i, int j) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((i < 0) || (j < i) || (j >= N))
+		throw "Index out of range";
+#endif
+	return Elem[Index(i, j)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // строка i
+constexpr TFixedRow<ValType, N> TMatrix<ValType, N>::operator[](int i)
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((i < 0) || (i >= N))
+		throw "Index out of range";
+#endif
+	return TFixedRow<ValType, N>(Elem + Index(i, i), i);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // строка i константной матрицы
+constexpr TFixedRow<const ValType, N> TMatrix<ValType, N>::operator[](int i) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((i < 0) || (i >= N))
+		throw "Index out of range";
+#endif
+	return TFixedRow<const ValType, N>(Elem + Index(i, i), i);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // сравнение
+constexpr bool TMatrix<ValType, N>::operator==(const TMatrix &mt) const
+{
+	bool eq = true;
+	Unroll<Count>([&](auto k) { eq = eq && (Elem[k] == mt.Elem[k]); });
+	return eq;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // сложение
+constexpr TMatrix<ValType, N> TMatrix<ValType, N>::operator+(const TMatrix &mt) const
+{
+	TMatrix r;
+	Unroll<Count>([&](auto k) { r.Elem[k] = Elem[k] + mt.Elem[k]; });
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // вычитание
+constexpr TMatrix<ValType, N> TMatrix<ValType, N>::operator-(const TMatrix &mt) const
+{
+	TMatrix r;
+	Unroll<Count>([&](auto k) { r.Elem[k] = Elem[k] - mt.Elem[k]; });
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // умножение на скаляр
+constexpr TMatrix<ValType, N> TMatrix<ValType, N>::operator*(const ValType &val) const
+{
+	TMatrix r;
+	Unroll<Count>([&](auto k) { r.Elem[k] = Elem[k] * val; });
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // сложение на месте
+constexpr TMatrix<ValType, N>& TMatrix<ValType, N>::operator+=(const TMatrix &mt)
+{
+	Unroll<Count>([&](auto k) { Elem[k] = Elem[k] + mt.Elem[k]; });
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // вычитание на месте
+constexpr TMatrix<ValType, N>& TMatrix<ValType, N>::operator-=(const TMatrix &mt)
+{
+	Unroll<Count>([&](auto k) { Elem[k] = Elem[k] - mt.Elem[k]; });
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // умножение: c(i, j) = a(i, i..j) * b(i..j, j)
+constexpr TMatrix<ValType, N> TMatrix<ValType, N>::operator*(const TMatrix &mt) const
+{
+	TMatrix r;
+	Unroll<N>([&](auto i)
+	{
+		constexpr int I = decltype(i)::value;
+		Unroll<N - I>([&](auto d)
+		{
+			constexpr int J = I + decltype(d)::value;
+			ValType s = ValType(0);
+			Unroll<J - I + 1>([&](auto k)
+			{
+				constexpr int K = I + decltype(k)::value;
+				s = s + Elem[Index(I, K)] * mt.Elem[Index(K, J)];
+			});
+			r.Elem[Index(I, J)] = s;
+		});
+	});
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // умножение на вектор: y(i) = a(i, i..N-1) * v(i..N-1)
+constexpr typename TMatrix<ValType, N>::TVec TMatrix<ValType, N>::operator*(const TVec &v) const
+{
+	TVec y{};
+	Unroll<N>([&](auto i)
+	{
+		constexpr int I = decltype(i)::value;
+		ValType s = ValType(0);
+		Unroll<N - I>([&](auto d)
+		{
+			constexpr int J = I + decltype(d)::value;
+			s = s + Elem[Index(I, J)] * v[J];
+		});
+		y[I] = s;
+	});
+	return y;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, int N> // решение Ux = b обратной подстановкой
+constexpr typename TMatrix<ValType, N>::TVec TMatrix<ValType, N>::Solve(const TVec &b) const
+{
+	TVec x{};
+	Unroll<N>([&](auto r)
+	{
+		constexpr int I = N - 1 - decltype(r)::value;
+		ValType s = b[I];
+		Unroll<N - 1 - I>([&](auto d)
+		{
+			constexpr int J = I + 1 + decltype(d)::value;
+			s = s - Elem[Index(I, J)] * x[J];
+		});
+		if (Elem[Index(I, I)] == ValType(0))
+			throw "Singular matrix";
+		x[I] = s / Elem[Index(I, I)];
+	});
+	return x;
+} /*-------------------------------------------------------------------------*/
+
+#endif
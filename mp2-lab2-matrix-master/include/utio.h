@@ -0,0 +1,347 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utio.h
+//
+// Быстрый текстовый ввод-вывод векторов и матриц с арифметическими
+// элементами. Числа форматируются to_chars в буфер, который передается
+// в поток крупными блоками, без сброса потока после строк. Ввод из потока
+// читает символы прямо из его буфера (streambuf) и разбирает числа
+// from_chars; ввод из памяти и файла (LoadText) при нескольких потоках
+// (SetNumThreads) делит текст на части по пробельным символам и разбирает
+// части параллельно. Матрица записывается компактно (только хранимый
+// треугольник, как operator<<) или полным квадратом с нулями под диагональю.
+
+#ifndef __UTIO_H__
+#define __UTIO_H__
+
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "utmatrix.h"
+
+using namespace std;
+
+enum TTextLayout { TEXT_COMPACT, TEXT_FULL }; // вид записи матрицы
+
+const size_t TEXT_BUFFER_SIZE = 1 << 20;     // размер буфера записи (байт)
+const size_t TEXT_PARALLEL_BYTES = 1 << 20;  // меньший текст разбирается в одном потоке
+const int TEXT_TOKEN_SIZE = 128;             // наибольшая длина числа в потоке
+
+inline bool IsTextSpace(char c)
+{
+	return (c == ' ') || (c == '\n') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f');
+} /*-------------------------------------------------------------------------*/
+
+// Число из [b, e) целиком; допускается знак '+', как у operator>>
+template <class T>
+T ParseTextValue(const char *b, const char *e)
+{
+	static_assert(is_arithmetic<T>::value && !is_same<T, bool>::value,
+		"text I/O supports arithmetic element types");
+	if ((b < e) && (*b == '+'))
+		b++;
+	T v;
+	from_chars_result r = from_chars(b, e, v);
+	if ((r.ec != errc()) || (r.ptr != e) || (b == e))
+		throw "Bad number";
+	return v;
+} /*-------------------------------------------------------------------------*/
+
+  // Запись
+
+// Буфер записи: числа форматируются в память и передаются в поток блоками;
+// остаток передается явным вызовом Flush (деструктор его не записывает)
+class TTextWriter
+{
+	ostream &Out;
+	vector<char> Buf;
+	size_t Pos;
+public:
+	explicit TTextWriter(ostream &out) : Out(out), Buf(TEXT_BUFFER_SIZE), Pos(0) {}
+	template <class T>
+	void Put(const T &v)            // число и пробел
+	{
+		static_assert(is_arithmetic<T>::value && !is_same<T, bool>::value,
+			"text I/O supports arithmetic element types");
+		if (Pos + TEXT_TOKEN_SIZE > Buf.size())
+			Flush();
+		to_chars_result r = to_chars(Buf.data() + Pos, Buf.data() + Buf.size(), v);
+		Pos = size_t(r.ptr - Buf.data());
+		Buf[Pos++] = ' ';
+	}
+	void PutChar(char c)
+	{
+		if (Pos == Buf.size())
+			Flush();
+		Buf[Pos++] = c;
+	}
+	void PutZeros(int n)            // n нулей (полная запись матрицы)
+	{
+		for (int k = 0; k < n; k++)
+		{
+			PutChar('0');
+			PutChar(' ');
+		}
+	}
+	void Flush()
+	{
+		Out.write(Buf.data(), streamsize(Pos));
+		Pos = 0;
+	}
+};
+
+template <class ValType>
+void WriteText(ostream &out, const TVector<ValType> &v)
+{
+	TTextWriter w(out);
+	const ValType *p = v.GetData();
+	for (int k = 0; k < v.GetSize(); k++)
+		w.Put(p[k]);
+	w.PutChar('\n');
+	w.Flush();
+	if (!out)
+		throw "Write error";
+} /*-------------------------------------------------------------------------*/
+
+// Строка i: компактно - элементы i..n-1, полностью - еще i нулей перед ними
+template <class ValType>
+void WriteText(ostream &out, const TMatrix<ValType> &mt, TTextLayout layout = TEXT_COMPACT)
+{
+	TTextWriter w(out);
+	const ValType *p = mt.GetData();
+	int n = mt.GetSize();
+	for (int i = 0; i < n; i++)
+	{
+		if (layout == TEXT_FULL)
+			w.PutZeros(i);
+		for (int k = mt.GetRowOffset(i); k < mt.GetRowOffset(i + 1); k++)
+			w.Put(p[k]);
+		w.PutChar('\n');
+	}
+	w.Flush();
+	if (!out)
+		throw "Write error";
+} /*-------------------------------------------------------------------------*/
+
+  // Чтение из потока
+
+// Следующее число из буфера потока; поток читается ровно до конца числа
+template <class T>
+T ReadTextValue(streambuf *sb)
+{
+	char tok[TEXT_TOKEN_SIZE];
+	int n = 0;
+	int c = sb->sgetc();
+	while ((c != char_traits<char>::eof()) && IsTextSpace(char(c)))
+		c = sb->snextc();
+	if (c == char_traits<char>::eof())
+		throw "Unexpected end of data";
+	while ((c != char_traits<char>::eof()) && !IsTextSpace(char(c)))
+	{
+		if (n == TEXT_TOKEN_SIZE)
+			throw "Bad number";
+		tok[n++] = char(c);
+		c = sb->snextc();
+	}
+	return ParseTextValue<T>(tok, tok + n);
+} /*-------------------------------------------------------------------------*/
+
+// Прочитать count чисел; sink(k, v) получает число с номером k
+template <class T, class F>
+void ReadTextStream(istream &in, size_t count, F sink)
+{
+	istream::sentry s(in, true);
+	if (!s)
+		throw "Read error";
+	streambuf *sb = in.rdbuf();
+	try
+	{
+		for (size_t k = 0; k < count; k++)
+			sink(k, ReadTextValue<T>(sb));
+	}
+	catch (...)
+	{
+		in.setstate(ios::failbit);
+		throw;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void ReadText(istream &in, TVector<ValType> &v)
+{
+	ValType *p = v.GetData();
+	ReadTextStream<ValType>(in, size_t(v.GetSize()), [&](size_t k, const ValType &x) { p[k] = x; });
+} /*-------------------------------------------------------------------------*/
+
+// Приемник чисел матрицы n x n, записанной полностью: элементы под
+// диагональю должны быть нулями
+template <class ValType>
+struct TFullMatrixSink
+{
+	TMatrix<ValType> &mt;
+	void operator()(size_t k, const ValType &x) const
+	{
+		int n = mt.GetSize(), i = int(k / n), j = int(k % n);
+		if (j >= i)
+			mt.GetData()[mt.GetRowOffset(i) + j - i] = x;
+		else if (x != ValType(0))
+			throw "Not upper triangular";
+	}
+};
+
+template <class ValType>
+void ReadText(istream &in, TMatrix<ValType> &mt, TTextLayout layout = TEXT_COMPACT)
+{
+	ValType *p = mt.GetData();
+	size_t n = size_t(mt.GetSize());
+	if (layout == TEXT_FULL)
+		ReadTextStream<ValType>(in, n * n, TFullMatrixSink<ValType>{ mt });
+	else
+		ReadTextStream<ValType>(in, size_t(mt.GetPackedSize()), [&](size_t k, const ValType &x) { p[k] = x; });
+} /*-------------------------------------------------------------------------*/
+
+  // Чтение из памяти
+
+// Число чисел в [b, e)
+inline size_t CountTextTokens(const char *b, const char *e)
+{
+	size_t n = 0;
+	bool in = false;
+	for (; b < e; b++)
+	{
+		bool sp = IsTextSpace(*b);
+		n += (!sp && !in) ? 1 : 0;
+		in = !sp;
+	}
+	return n;
+} /*-------------------------------------------------------------------------*/
+
+// Разобрать числа из [b, e), первое из которых имеет номер first;
+// sink получает числа с номерами меньше count; результат - номер
+// следующего за разобранными числа
+template <class T, class F>
+size_t ParseTextRange(const char *b, const char *e, size_t first, size_t count, F &sink)
+{
+	size_t k = first;
+	for (; k < count; k++)
+	{
+		while ((b < e) && IsTextSpace(*b))
+			b++;
+		if (b == e)
+			break;
+		const char *t = b;
+		while ((b < e) && !IsTextSpace(*b))
+			b++;
+		sink(k, ParseTextValue<T>(t, b));
+	}
+	return k;
+} /*-------------------------------------------------------------------------*/
+
+// Разобрать первые count чисел текста [b, e). Текст длиннее
+// TEXT_PARALLEL_BYTES делится на части по пробельным символам; потоки
+// сначала считают числа своих частей, затем разбирают их на свои места
+template <class T, class F>
+void ParseText(const char *b, const char *e, size_t count, F sink)
+{
+	int threads = GetNumThreads();
+	size_t bytes = size_t(e - b);
+	if ((threads <= 1) || (bytes < TEXT_PARALLEL_BYTES))
+	{
+		if (ParseTextRange<T>(b, e, 0, count, sink) < count)
+			throw "Unexpected end of data";
+		return;
+	}
+	vector<const char*> cut(threads + 1);
+	cut[0] = b;
+	cut[threads] = e;
+	for (int t = 1; t < threads; t++)
+	{
+		const char *p = max(cut[t - 1], b + bytes / threads * t);
+		while ((p < e) && !IsTextSpace(*p))
+			p++;
+		cut[t] = p;
+	}
+	vector<size_t> first(threads + 1, 0);
+	function<void(int)> counter = [&](int t) { first[t + 1] = CountTextTokens(cut[t], cut[t + 1]); };
+	TThreadPool::Instance().Run(threads, counter);
+	for (int t = 0; t < threads; t++)
+		first[t + 1] += first[t];
+	if (first[threads] < count)
+		throw "Unexpected end of data";
+	function<void(int)> parser = [&](int t) { ParseTextRange<T>(cut[t], cut[t + 1], first[t], count, sink); };
+	TThreadPool::Instance().Run(threads, parser);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void ReadText(const char *b, const char *e, TVector<ValType> &v)
+{
+	ValType *p = v.GetData();
+	ParseText<ValType>(b, e, size_t(v.GetSize()), [p](size_t k, const ValType &x) { p[k] = x; });
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void ReadText(const char *b, const char *e, TMatrix<ValType> &mt, TTextLayout layout = TEXT_COMPACT)
+{
+	ValType *p = mt.GetData();
+	size_t n = size_t(mt.GetSize());
+	if (layout == TEXT_FULL)
+		ParseText<ValType>(b, e, n * n, TFullMatrixSink<ValType>{ mt });
+	else
+		ParseText<ValType>(b, e, size_t(mt.GetPackedSize()), [p](size_t k, const ValType &x) { p[k] = x; });
+} /*-------------------------------------------------------------------------*/
+
+  // Файлы
+
+// Весь файл одним чтением
+inline string ReadTextFile(const string &fileName)
+{
+	ifstream in(fileName.c_str(), ios::binary | ios::ate);
+	if (!in)
+		throw "Cannot open file";
+	string text(size_t(in.tellg()), '\0');
+	in.seekg(0);
+	if (!in.read(&text[0], streamsize(text.size())))
+		throw "Read error";
+	return text;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void LoadText(const string &fileName, TVector<ValType> &v)
+{
+	string text = ReadTextFile(fileName);
+	ReadText(text.data(), text.data() + text.size(), v);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void LoadText(const string &fileName, TMatrix<ValType> &mt, TTextLayout layout = TEXT_COMPACT)
+{
+	string text = ReadTextFile(fileName);
+	ReadText(text.data(), text.data() + text.size(), mt, layout);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void SaveText(const string &fileName, const TVector<ValType> &v)
+{
+	ofstream out(fileName.c_str(), ios::binary | ios::trunc);
+	if (!out)
+		throw "Cannot open file";
+	WriteText(out, v);
+	out.close(); // ошибка записи при закрытии файла не теряется в деструкторе
+	if (!out)
+		throw "Write error";
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void SaveText(const string &fileName, const TMatrix<ValType> &mt, TTextLayout layout = TEXT_COMPACT)
+{
+	ofstream out(fileName.c_str(), ios::binary | ios::trunc);
+	if (!out)
+		throw "Cannot open file";
+	WriteText(out, mt, layout);
+	out.close();
+	if (!out)
+		throw "Write error";
+} /*-------------------------------------------------------------------------*/
+
+#endif
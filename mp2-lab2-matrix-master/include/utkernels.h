@@ -0,0 +1,298 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utkernels.h
+//
+// Вычислительные ядра над верхнетреугольными матрицами в упакованном
+// построчном формате: элемент (i, j), j >= i, хранится в a[off[i] + j - i],
+// где off - таблица смещений строк (см. TMatrix::GetRowOffset).
+
+#ifndef __UTKERNELS_H__
+#define __UTKERNELS_H__
+
+#include <algorithm>
+#include <memory>
+#include "utsimd.h"
+#include "utparallel.h"
+
+using namespace std;
+
+// Размеры блоков умножения: MR x NR - блок результата в регистрах (задается
+// микроядром текущего уровня SIMD, см. MakeSimdKernels), MC x KC - панель a
+// (в L2), KC x NC - панель b (в L3)
+template <class T>
+struct TMulBlocking
+{
+	int MR, NR, MC, KC, NC;
+	void (*Micro)(const T *ap, const T *bp, int k, T *acc); // микроядро MR x NR
+};
+
+// Блоки умножения для текущего уровня; MC кратно MR, NC и KC - кратны NR
+template <class T>
+TMulBlocking<T> MulBlocking()
+{
+	TMulBlocking<T> b;
+	if constexpr (TSimdSupported<T>::value)
+	{
+		const TSimdKernels<T> &k = SimdKernels<T>();
+		b.MR = k.MR;
+		b.NR = k.NR;
+		b.Micro = k.MulMicro;
+	}
+	else
+	{
+		b.MR = TScalarMicro<T>::MR;
+		b.NR = TScalarMicro<T>::NR;
+		b.Micro = ScalarMulMicro<T, TScalarMicro<T>::MR, TScalarMicro<T>::NR>;
+	}
+	b.MC = (64 + b.MR - 1) / b.MR * b.MR;
+	b.KC = 256;
+	b.NC = 512;
+	return b;
+} /*-------------------------------------------------------------------------*/
+
+// Упаковка блока b[pc..pc+kc) x [jc..jc+nc) в микропанели по nr столбцов;
+// нули под диагональю и за границей матрицы записываются явно
+template <class T>
+void PackTriB(const T *b, const int *off, int n, int pc, int kc, int jc, int nc, int nr, T *bp)
+{
+	for (int jr = 0; jr < nc; jr += nr, bp += kc * nr)
+		for (int k = 0; k < kc; k++)
+		{
+			int kk = pc + k;
+			for (int jj = 0; jj < nr; jj++)
+			{
+				int j = jc + jr + jj;
+				bp[k * nr + jj] = ((j < n) && (kk <= j)) ? b[off[kk] + j - kk] : T(0);
+			}
+		}
+} /*-------------------------------------------------------------------------*/
+
+// Упаковка блока a[ic..ic+mc) x [pc..pc+kc) в микропанели по mr строк
+template <class T>
+void PackTriA(const T *a, const int *off, int n, int ic, int mc, int pc, int kc, int mr, T *ap)
+{
+	for (int ir = 0; ir < mc; ir += mr, ap += kc * mr)
+		for (int k = 0; k < kc; k++)
+		{
+			int kk = pc + k;
+			for (int ii = 0; ii < mr; ii++)
+			{
+				int i = ic + ir + ii;
+				ap[k * mr + ii] = ((i < n) && (kk >= i)) ? a[off[i] + kk - i] : T(0);
+			}
+		}
+} /*-------------------------------------------------------------------------*/
+
+// Упаковка блока плотной матрицы b (строки по ldb элементов)
+// [pc..pc+kc) x [jc..jc+nc) в микропанели по nr столбцов
+template <class T>
+void PackDenseB(const T *b, int ldb, int pc, int kc, int jc, int nc, int nr, T *bp)
+{
+	for (int jr = 0; jr < nc; jr += nr, bp += kc * nr)
+		for (int k = 0; k < kc; k++)
+		{
+			const T *bk = b + size_t(pc + k) * ldb + jc + jr;
+			for (int jj = 0; jj < nr; jj++)
+				bp[k * nr + jj] = (jr + jj < nc) ? bk[jj] : T(0);
+		}
+} /*-------------------------------------------------------------------------*/
+
+// Микроблок: произведение микропанелей по k из [kb, ke) прибавляется к
+// верхнему треугольнику c
+template <class T>
+void TriMulMicro(const TMulBlocking<T> &B, const T *ap, const T *bp, int kb, int ke,
+	T *c, const int *off, int n, int i0, int j0)
+{
+	alignas(64) T acc[SIMD_MICRO_MAX];
+	B.Micro(ap + kb * B.MR, bp + kb * B.NR, ke - kb, acc);
+	for (int ii = 0; ii < B.MR; ii++)
+	{
+		int i = i0 + ii;
+		if (i >= n)
+			break;
+		T *ci = c + off[i] - i;
+		const T *ai = acc + ii * B.NR;
+		for (int jj = max(0, i - j0); (jj < B.NR) && (j0 + jj < n); jj++)
+			ci[j0 + jj] = ci[j0 + jj] + ai[jj];
+	}
+} /*-------------------------------------------------------------------------*/
+
+// c = a * b для верхнетреугольных a, b размера n; c должна быть обнулена.
+// Нулевая нижняя часть не обрабатывается: блоки целиком под диагональю
+// пропускаются, а диапазон k каждого микроблока сужен до [i0, j0 + NR),
+// поэтому работа составляет около n^3/6 умножений-сложений. Панель b
+// упаковывается один раз, блоки строк a (по MC) раздаются потокам пула
+// через один - нижние блоки короче; у каждой части своя панель a
+template <class T>
+void TriMulPacked(const T *a, const T *b, T *c, const int *off, int n)
+{
+	if (n == 0)
+		return;
+	const TMulBlocking<T> B = MulBlocking<T>();
+	const int threads = max(1, GetNumThreads());
+	unique_ptr<T[]> abuf(new T[size_t(threads) * B.MC * B.KC]), bbuf(new T[B.KC * B.NC]);
+	T *bp = bbuf.get();
+	for (int jc = 0; jc < n; jc += B.NC)
+	{
+		int nc = min(B.NC, n - jc);
+		for (int pc = 0; pc < jc + nc; pc += B.KC)        // k <= j < jc + nc
+		{
+			int kc = min(B.KC, jc + nc - pc);
+			PackTriB(b, off, n, pc, kc, jc, nc, B.NR, bp);
+			int blocks = (pc + kc + B.MC - 1) / B.MC;      // i <= k < pc + kc
+			int tasks = min(threads, blocks);
+			ParallelTasks(tasks, (long long)n * (n + 1) / 2, [&](int t)
+			{
+				T *ap = abuf.get() + size_t(t) * B.MC * B.KC;
+				for (int blk = t; blk < blocks; blk += tasks)
+				{
+					int ic = blk * B.MC, mc = min(B.MC, pc + kc - ic);
+					PackTriA(a, off, n, ic, mc, pc, kc, B.MR, ap);
+					for (int jr = 0; jr < nc; jr += B.NR)
+						for (int ir = 0; ir < mc; ir += B.MR)
+						{
+							int i0 = ic + ir, j0 = jc + jr;
+							int kb = max(pc, i0) - pc, ke = min(pc + kc, j0 + B.NR) - pc;
+							if ((i0 >= j0 + B.NR) || (kb >= ke))
+								continue;
+							TriMulMicro(B, ap + ir * kc, bp + jr * kc, kb, ke, c, off, n, i0, j0);
+						}
+				}
+			});
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+// y = a * x: строки a читаются подряд, каждая строка - скалярное
+// произведение с хвостом x (ядро Dot из utsimd.h)
+template <class T>
+void TriMatVecPacked(const T *a, const int *off, int n, const T *x, T *y)
+{
+	T (*dot)(const T*, const T*, int) = ScalarDot<T>;
+	if constexpr (TSimdSupported<T>::value)
+		dot = SimdKernels<T>().Dot;
+	for (int i = 0; i < n; i++)
+		y[i] = dot(a + off[i], x + i, n - i);
+} /*-------------------------------------------------------------------------*/
+
+// y = a^T * x: столбец j у a^T - строка j у a, поэтому вместо чтения
+// столбцов с шагом выполняется проход по строкам y[i..n) += x[i] * a[i][i..n)
+// (ядро Axpy); y должен быть обнулен
+template <class T>
+void TriMatTVecPacked(const T *a, const int *off, int n, const T *x, T *y)
+{
+	void (*axpy)(T*, T, const T*, int) = ScalarAxpy<T>;
+	if constexpr (TSimdSupported<T>::value)
+		axpy = SimdKernels<T>().Axpy;
+	for (int i = 0; i < n; i++)
+		axpy(y + i, x[i], a + off[i], n - i);
+} /*-------------------------------------------------------------------------*/
+
+// x[r0..r1) -= a[r0..r1) x [r1..n) * x[r1..n) для x из m столбцов по строкам.
+// Блок a лежит целиком над диагональю; панели a и x упаковываются
+// (PackTriA, PackDenseB) и перемножаются микроядром, как в TriMulPacked
+template <class T>
+void TriSolveUpdate(const TMulBlocking<T> &B, const T *a, const int *off, int n,
+	int r0, int r1, T *x, int m, T *ap, T *bp)
+{
+	int mc = r1 - r0;
+	alignas(64) T acc[SIMD_MICRO_MAX];
+	for (int pc = r1; pc < n; pc += B.KC)
+	{
+		int kc = min(B.KC, n - pc);
+		PackTriA(a, off, n, r0, mc, pc, kc, B.MR, ap);
+		for (int jc = 0; jc < m; jc += B.NC)
+		{
+			int nc = min(B.NC, m - jc);
+			PackDenseB(x, m, pc, kc, jc, nc, B.NR, bp);
+			for (int jr = 0; jr < nc; jr += B.NR)
+				for (int ir = 0; ir < mc; ir += B.MR)
+				{
+					B.Micro(ap + ir * kc, bp + jr * kc, kc, acc);
+					for (int ii = 0; (ii < B.MR) && (ir + ii < mc); ii++)
+					{
+						T *xi = x + size_t(r0 + ir + ii) * m + jc + jr;
+						const T *ai = acc + ii * B.NR;
+						for (int jj = 0; (jj < B.NR) && (jr + jj < nc); jj++)
+							xi[jj] = xi[jj] - ai[jj];
+					}
+				}
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+// Решение a * x = b обратной подстановкой; x (n x m по строкам) содержит
+// правые части и заменяется решением, диагональ a не должна содержать нулей.
+// Строки обрабатываются блоками по NB = MC снизу вверх (блочная строка a
+// помещается в одну панель умножения): сначала из блока вычитается
+// произведение его блочной строки a на найденную часть x (основная часть
+// работы), затем решается небольшая треугольная система диагонального
+// блока. При m > 1 вычитание - упакованное блочное умножение
+// TriSolveUpdate, при m == 1 - скалярное произведение строки a с найденной
+// частью x (ядро Dot)
+template <class T>
+void TriSolvePacked(const T *a, const int *off, int n, T *x, int m)
+{
+	const TMulBlocking<T> B = MulBlocking<T>();
+	const int NB = B.MC;
+	T (*dot)(const T*, const T*, int) = ScalarDot<T>;
+	void (*axpy)(T*, T, const T*, int) = ScalarAxpy<T>;
+	if constexpr (TSimdSupported<T>::value)
+	{
+		dot = SimdKernels<T>().Dot;
+		axpy = SimdKernels<T>().Axpy;
+	}
+	unique_ptr<T[]> abuf, bbuf;
+	if ((m > 1) && (n > NB))
+	{
+		abuf.reset(new T[B.MC * B.KC]);
+		bbuf.reset(new T[B.KC * B.NC]);
+	}
+	for (int r1 = n; r1 > 0; r1 -= NB)
+	{
+		int r0 = max(0, r1 - NB);
+		if ((r1 < n) && (m == 1))
+			for (int i = r0; i < r1; i++)
+				x[i] = x[i] - dot(a + off[i] + (r1 - i), x + r1, n - r1);
+		else if (r1 < n)
+			TriSolveUpdate(B, a, off, n, r0, r1, x, m, abuf.get(), bbuf.get());
+		for (int i = r1 - 1; i >= r0; i--)
+		{
+			const T *ai = a + off[i] - i;
+			T *xi = x + size_t(i) * m;
+			if (m == 1)
+				xi[0] = xi[0] - dot(ai + i + 1, x + i + 1, r1 - i - 1);
+			else
+				for (int k = i + 1; k < r1; k++)
+					axpy(xi, T(0) - ai[k], x + size_t(k) * m, m);
+			for (int c = 0; c < m; c++)
+				xi[c] = xi[c] / ai[i];
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+// Решение a^T * x = b прямой подстановкой (a^T - нижнетреугольная); x
+// (n x m по строкам) содержит правые части и заменяется решением. Столбец
+// a^T - строка a, поэтому после нахождения x[k] из следующих уравнений
+// вычитается x[k] * a[k][k+1..n) проходом по строке (ядро Axpy)
+template <class T>
+void TriSolveTransPacked(const T *a, const int *off, int n, T *x, int m)
+{
+	void (*axpy)(T*, T, const T*, int) = ScalarAxpy<T>;
+	if constexpr (TSimdSupported<T>::value)
+		axpy = SimdKernels<T>().Axpy;
+	for (int k = 0; k < n; k++)
+	{
+		const T *ak = a + off[k] - k; // ak[j] = a[k][j]
+		T *xk = x + size_t(k) * m;
+		for (int c = 0; c < m; c++)
+			xk[c] = xk[c] / ak[k];
+		if (m == 1)
+			axpy(x + k + 1, T(0) - xk[0], ak + k + 1, n - k - 1);
+		else
+			for (int j = k + 1; j < n; j++)
+				axpy(x + size_t(j) * m, T(0) - ak[j], xk, m);
+	}
+} /*-------------------------------------------------------------------------*/
+
+#endif
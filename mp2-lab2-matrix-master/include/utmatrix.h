@@ -8,12 +8,214 @@
 #ifndef __TMATRIX_H__
 #define __TMATRIX_H__
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "utsimd.h"
+#include "utkernels.h"
+#include "utparallel.h"
+#include "utpool.h"
 
 using namespace std;
 
 const int MAX_VECTOR_SIZE = 100000000;
 const int MAX_MATRIX_SIZE = 10000;
+// Проверка индексов в TVector::operator[]: 1 - индекс проверяется на
+// принадлежность [StartIndex, StartIndex + Size), 0 - не проверяется
+// (сборка с -DUTMATRIX_BOUNDS_CHECK=0, доступ - одно чтение памяти)
+#ifndef UTMATRIX_BOUNDS_CHECK
+#define UTMATRIX_BOUNDS_CHECK 1
+#endif
+// Копирование при записи: 1 - копия вектора или матрицы разделяет буфер
+// с оригиналом (счетчик ссылок), собственный буфер создается при первом
+// обращении на запись (неконстантные operator[], at_unchecked, GetData,
+// begin, Rows, операции на месте, в том числе через интерфейс базового
+// класса TMatrix - TVector<TVector<T> >); 0 - копирование всегда глубокое.
+// Буфер, на элементы которого выдана изменяемая ссылка, указатель,
+// итератор или представление (utview.h), больше не разделяется: его копии
+// глубокие, поэтому запись через ссылку не видна в копиях
+#ifndef UTMATRIX_COW
+#define UTMATRIX_COW 0
+#endif
+
+  // Счетчик ссылок на разделяемый буфер (UTMATRIX_COW)
+
+typedef atomic<int> TRefCount;
+
+// Статистика копирования при записи (общая для всех потоков)
+struct TCowStats
+{
+	long long Shared;   // копий, разделивших буфер с оригиналом
+	long long Detached; // из них получили собственный буфер при записи
+	long long Avoided() const { return Shared - Detached; } // несостоявшихся копирований
+};
+
+inline atomic<long long>* CowCounters() // Shared, Detached
+{
+	static atomic<long long> c[2];
+	return c;
+}
+
+inline TCowStats GetCowStats()
+{
+	TCowStats s;
+	s.Shared = CowCounters()[0].load(memory_order_relaxed);
+	s.Detached = CowCounters()[1].load(memory_order_relaxed);
+	return s;
+}
+
+inline void ResetCowStats()
+{
+	CowCounters()[0].store(0, memory_order_relaxed);
+	CowCounters()[1].store(0, memory_order_relaxed);
+}
+
+// Счетчик нового буфера: nullptr, если копирование при записи выключено
+inline TRefCount* CowNew()
+{
+	return UTMATRIX_COW ? new TRefCount(1) : nullptr;
+}
+
+// Еще одна ссылка на буфер
+inline TRefCount* CowShare(TRefCount *r)
+{
+	r->fetch_add(1, memory_order_relaxed);
+	CowCounters()[0].fetch_add(1, memory_order_relaxed);
+	return r;
+}
+
+// Снять ссылку; true - ссылка была последней (счетчик удален, буфер нужно
+// освободить). nullptr - буфер не разделяется
+inline bool CowRelease(TRefCount *r)
+{
+	if (r == nullptr)
+		return true;
+	if ((r->load(memory_order_relaxed) > 0) && (r->fetch_sub(1, memory_order_acq_rel) != 1))
+		return false; // -1 (CowLeak) - единственная ссылка
+	delete r;
+	return true;
+}
+
+// Разделяется ли буфер с другими копиями
+inline bool CowShared(const TRefCount *r)
+{
+	return UTMATRIX_COW && (r != nullptr) && (r->load(memory_order_acquire) > 1);
+}
+
+// Можно ли разделить буфер с новой копией: false без UTMATRIX_COW и после CowLeak
+inline bool CowShareable(const TRefCount *r)
+{
+	return UTMATRIX_COW && (r != nullptr) && (r->load(memory_order_relaxed) > 0);
+}
+
+// Наружу выдана ссылка на элементы собственного (неразделяемого) буфера:
+// счетчик -1, копии буфера с этого момента глубокие
+inline void CowLeak(TRefCount *r)
+{
+	if (r != nullptr)
+		r->store(-1, memory_order_relaxed);
+}
+
+const size_t MATRIX_ALIGNMENT = POOL_ALIGNMENT; // выравнивание буферов векторов и матриц (байт)
+
+// Выровненный буфер из n элементов; память берется из пула потока (utpool.h).
+// Элементы создаются конструктором по умолчанию: у встроенных типов они не
+// инициализируются (как у new ValType[n]), нули записываются явно там, где
+// они нужны
+template <class ValType>
+ValType* AllocAligned(size_t n)
+{
+	const size_t al = max(MATRIX_ALIGNMENT, alignof(ValType));
+	ValType *p = static_cast<ValType*>(PoolAlloc(n * sizeof(ValType), al));
+	try
+	{
+		uninitialized_default_construct_n(p, n);
+	}
+	catch (...)
+	{
+		PoolFree(p, n * sizeof(ValType), al);
+		throw;
+	}
+	return p;
+} /*-------------------------------------------------------------------------*/
+
+// То же, элементы создаются конструктором ValType(args...)
+template <class ValType, class... Args>
+ValType* AllocAligned(size_t n, const Args&... args)
+{
+	const size_t al = max(MATRIX_ALIGNMENT, alignof(ValType));
+	ValType *p = static_cast<ValType*>(PoolAlloc(n * sizeof(ValType), al));
+	size_t i = 0;
+	try
+	{
+		for (; i < n; i++)
+			new (p + i) ValType(args...);
+	}
+	catch (...)
+	{
+		destroy_n(p, i);
+		PoolFree(p, n * sizeof(ValType), al);
+		throw;
+	}
+	return p;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void FreeAligned(ValType *p, size_t n)
+{
+	if (p == nullptr)
+		return;
+	destroy_n(p, n);
+	PoolFree(p, n * sizeof(ValType), max(MATRIX_ALIGNMENT, alignof(ValType)));
+} /*-------------------------------------------------------------------------*/
+
+// y[0..n) += v * x[0..n) (ядро Axpy из utsimd.h)
+template <class ValType>
+void AxpyRange(ValType *y, const ValType &v, const ValType *x, int n)
+{
+	if constexpr (TSimdSupported<ValType>::value)
+		SimdKernels<ValType>().Axpy(y, v, x, n);
+	else
+		ScalarAxpy(y, v, x, n);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> class TVector;
+template <class ValType, int N = 0> class TMatrix; // N > 0 - размер задан при компиляции (utfixed.h)
+template <class L, class R, class Op> class TBinExpr;
+template <class L, class Op> class TScalarExpr;
+struct TOpAdd;
+struct TOpSub;
+struct TOpMul;
+template <class ValType, class E> void EvalExpr(ValType *dst, const E &e, int n);
+
+// Свойства операндов ленивых выражений: Kind = 1 - вектор, 2 - матрица,
+// 3 - транспонированная матрица (utview.h), 0 - не выражение; Leaf - вектор
+// или матрица, хранящие данные
+template <class E>
+struct TExprTraits
+{
+	static const int Kind = 0;
+	static const bool Leaf = false;
+};
+
+// Диапазон [First, Last) для цикла for и алгоритмов STL
+template <class It>
+struct TRange
+{
+	It First, Last;
+	TRange(It f, It l) : First(f), Last(l) {}
+	It begin() const { return First; }
+	It end() const { return Last; }
+	int size() const { return int(Last - First); }
+};
+
+// E - узел выражения вида Kind (не вектор и не матрица)
+template <class E, int Kind>
+struct IsExprNode : integral_constant<bool,
+	(TExprTraits<E>::Kind == Kind) && !TExprTraits<E>::Leaf> {};
 
 // Шаблон вектора
 template <class ValType>
@@ -23,30 +225,88 @@ protected:
 	ValType *pVector;
 	int Size;       // размер вектора
 	int StartIndex; // индекс первого элемента вектора
+	bool OwnMemory; // false - вектор является строкой упакованной матрицы
+	TRefCount *pRefs; // ссылки на pVector (UTMATRIX_COW), nullptr - не разделяется,
+	                  // -1 - выдана ссылка (CowLeak); у базовой части TMatrix -
+	                  // ссылки на всю матрицу
+
+	TVector(ValType *p, int s, int si);       // представление над чужой памятью
+	void Detach();                            // собственный буфер перед записью
+	void Leak() { Detach(); CowLeak(pRefs); } // собственный буфер перед выдачей ссылки
+	template <class T>                        // отделить матрицу, базовой частью
+	static void DetachMatrix(TVector<TVector<T> > *v); // которой является *v
+	static void DetachMatrix(void *) {}
+	void ReleaseBuffer();                     // освободить буфер или ссылку на него
+	template <class T, int N> friend class TMatrix;
+	template <class T> friend class TMappedVector;
+	template <class E> friend struct TExprTraits;
 public:
 	TVector(int s = 10, int si = 0);
 	TVector(const TVector &v);                // конструктор копирования
+	TVector(TVector &&v);                     // конструктор перемещения
+	template <class E, class = typename enable_if<IsExprNode<E, 1>::value>::type>
+	TVector(const E &e);                      // вычисление выражения
 	~TVector();
-	int GetSize() { return Size; } // размер вектора
-	int GetStartIndex() { return StartIndex; } // индекс первого элемента
-	ValType& operator[](int pos);             // доступ
+	int GetSize() const { return Size; } // размер вектора
+	int GetStartIndex() const { return StartIndex; } // индекс первого элемента
+	ValType* GetData() { Leak(); return pVector; } // элементы
+	const ValType* GetData() const { return pVector; }
+
+	// Итераторы STL: элементы лежат подряд, поэтому итератор - указатель
+	// (непрерывный, годится для std::execution::par_unseq)
+	typedef ValType value_type;
+	typedef ValType* iterator;
+	typedef const ValType* const_iterator;
+	iterator begin() { Leak(); return pVector; }
+	iterator end() { Leak(); return pVector + Size; }
+	const_iterator begin() const { return pVector; }
+	const_iterator end() const { return pVector + Size; }
+	const_iterator cbegin() const { return pVector; }
+	const_iterator cend() const { return pVector + Size; }
+
+	ValType& operator[](int pos);             // доступ (см. UTMATRIX_BOUNDS_CHECK)
+	const ValType& operator[](int pos) const;
+	ValType& at_unchecked(int pos) { Leak(); return pVector[pos - StartIndex]; } // доступ без проверки
+	const ValType& at_unchecked(int pos) const { return pVector[pos - StartIndex]; }
 	bool operator==(const TVector &v) const;  // сравнение
 	bool operator!=(const TVector &v) const;  // сравнение
 	TVector& operator=(const TVector &v);     // присваивание
+	TVector& operator=(TVector &&v);          // перемещающее присваивание
+	template <class E>
+	typename enable_if<IsExprNode<E, 1>::value, TVector&>::type
+		operator=(const E &e);                // вычисление выражения за один проход
+	template <class E>                        // сложение и вычитание на месте, без
+	typename enable_if<TExprTraits<E>::Kind == 1, TVector&>::type // выделения памяти;
+		operator+=(const E &e);               // e - вектор или выражение
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 1, TVector&>::type
+		operator-=(const E &e);
+	TVector& operator*=(const ValType &val);  // умножение на скаляр на месте
+	TVector& Axpy(const ValType &alpha, const TVector &x); // *this += alpha * x
+
+	// Сложение, вычитание и умножение на скаляр векторов-переменных строят
+	// ленивые выражения (см. TBinExpr); ниже - операции над временными векторами
 
 											  // скалярные операции
-	TVector  operator+(const ValType &val);   // прибавить скаляр
-	TVector  operator-(const ValType &val);   // вычесть скаляр
-	TVector  operator*(const ValType &val);   // умножить на скаляр
+	TVector  operator+(const ValType &val) &&;  // операции над временным вектором
+	TVector  operator-(const ValType &val) &&;  // выполняются в его же памяти
+	TVector  operator*(const ValType &val) &&;
 
 											  // векторные операции
-	TVector  operator+(const TVector &v);     // сложение
-	TVector  operator-(const TVector &v);     // вычитание
-	ValType  operator*(const TVector &v);     // скалярное произведение
+	template <class V>                        // результат - в памяти временного v
+	typename enable_if<is_same<V, TVector>::value, TVector>::type operator+(V &&v) &;
+	template <class V>
+	typename enable_if<is_same<V, TVector>::value, TVector>::type operator-(V &&v) &;
+	TVector  operator+(const TVector &v) &&;  // результат - в памяти *this
+	TVector  operator-(const TVector &v) &&;
+	template <class V>                        // скалярное произведение; шаблон,
+	typename enable_if<is_same<V, TVector>::value, ValType>::type
+		operator*(const V &v) const;          // чтобы v * 3 не стало v * TVector(3)
 
 											  // ввод-вывод
 	friend istream& operator>>(istream &in, TVector &v)
 	{
+		v.Detach();
 		for (int i = 0; i < v.Size; i++)
 			in >> v.pVector[i];
 		return in;
@@ -68,7 +328,50 @@ TVector<ValType>::TVector(int s, int si)
 		throw "Negative StartIndex";
 	Size = s;
 	StartIndex = si;
-	pVector = new ValType[Size];
+	OwnMemory = true;
+	pVector = AllocAligned<ValType>(Size);
+	pRefs = CowNew();
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // представление над чужой памятью
+TVector<ValType>::TVector(ValType *p, int s, int si)
+{
+	Size = s;
+	StartIndex = si;
+	OwnMemory = false;
+	pVector = p;
+	pRefs = nullptr;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // собственный буфер перед записью
+void TVector<ValType>::Detach()
+{
+	if (!CowShared(pRefs))
+		return;
+	if (!OwnMemory) // базовая часть TMatrix: строки отделяются вместе с матрицей
+	{
+		DetachMatrix(this);
+		return;
+	}
+	ValType *p = AllocAligned<ValType>(Size);
+	copy_n(pVector, Size, p);
+	ReleaseBuffer();
+	pVector = p;
+	pRefs = CowNew();
+	CowCounters()[1].fetch_add(1, memory_order_relaxed);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class T> // отделить матрицу, базовой частью которой является *v
+void TVector<ValType>::DetachMatrix(TVector<TVector<T> > *v)
+{
+	static_cast<TMatrix<T>*>(v)->Detach();
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // освободить буфер, если ссылка на него последняя
+void TVector<ValType>::ReleaseBuffer()
+{
+	if (OwnMemory && CowRelease(pRefs))
+		FreeAligned(pVector, Size);
 } /*-------------------------------------------------------------------------*/
 
 template <class ValType> //конструктор копирования
@@ -76,22 +379,77 @@ TVector<ValType>::TVector(const TVector<ValType> &v)
 {
 	Size = v.Size;
 	StartIndex = v.StartIndex;
-	pVector = new ValType[Size];
+	OwnMemory = true;
+	if (v.OwnMemory && CowShareable(v.pRefs)) // общий буфер до первой записи (UTMATRIX_COW)
+	{
+		pVector = v.pVector;
+		pRefs = CowShare(v.pRefs);
+		return;
+	}
+	pVector = AllocAligned<ValType>(Size);
+	pRefs = CowNew();
 	for (int i = 0; i < Size; i++)
 		pVector[i] = v.pVector[i];
 } /*-------------------------------------------------------------------------*/
 
+template <class ValType> // конструктор перемещения
+TVector<ValType>::TVector(TVector<ValType> &&v)
+{
+	Size = v.Size;
+	StartIndex = v.StartIndex;
+	OwnMemory = true;
+	if (v.OwnMemory)
+	{
+		pVector = v.pVector;
+		pRefs = v.pRefs;
+		v.pVector = nullptr;
+		v.pRefs = nullptr;
+		v.Size = 0;
+	}
+	else // память строки матрицы забрать нельзя - копируем
+	{
+		pVector = AllocAligned<ValType>(Size);
+		pRefs = CowNew();
+		for (int i = 0; i < Size; i++)
+			pVector[i] = v.pVector[i];
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E, class> // вычисление выражения
+TVector<ValType>::TVector(const E &e)
+{
+	Size = e.GetSize();
+	StartIndex = e.GetStartIndex();
+	OwnMemory = true;
+	pVector = AllocAligned<ValType>(Size);
+	pRefs = CowNew();
+	EvalExpr(pVector, e, Size);
+} /*-------------------------------------------------------------------------*/
+
 template <class ValType>
 TVector<ValType>::~TVector()
 {
-	delete[] pVector;
+	ReleaseBuffer();
 } /*-------------------------------------------------------------------------*/
 
 template <class ValType> // доступ
 ValType& TVector<ValType>::operator[](int pos)
 {
-	if ((pos > Size + StartIndex) || (pos < 0))
-		throw "Negative pos";
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < StartIndex) || (pos >= StartIndex + Size))
+		throw "Index out of range";
+#endif
+	Leak();
+	return pVector[pos - StartIndex];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ к константному вектору
+const ValType& TVector<ValType>::operator[](int pos) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < StartIndex) || (pos >= StartIndex + Size))
+		throw "Index out of range";
+#endif
 	return pVector[pos - StartIndex];
 } /*-------------------------------------------------------------------------*/
 
@@ -121,73 +479,196 @@ TVector<ValType>& TVector<ValType>::operator=(const TVector &v)
 {
 	if (this != &v)
 	{
-		if (Size != v.Size)
+		if (OwnMemory && v.OwnMemory && CowShareable(v.pRefs)) // общий буфер (UTMATRIX_COW)
 		{
-			delete[] pVector;
+			TVector t(v);
+			return *this = move(t);
+		}
+		if (!OwnMemory)
+			Detach(); // базовая часть TMatrix
+		if ((Size != v.Size) || CowShared(pRefs))
+		{
+			if (!OwnMemory) // строку упакованной матрицы нельзя переразместить
+				throw "Error";
+			ValType *p = AllocAligned<ValType>(v.Size);
+			ReleaseBuffer();
+			pVector = p;
+			pRefs = CowNew();
 			Size = v.Size;
-			pVector = new ValType[Size];
 		}
-		StartIndex = v.StartIndex;
+		if (OwnMemory)
+			StartIndex = v.StartIndex;
 		for (int i = 0; i < Size; i++)
 			pVector[i] = v.pVector[i];
 	}
 	return *this;
 } /*-------------------------------------------------------------------------*/
 
-template <class ValType> // прибавить скаляр
-TVector<ValType> TVector<ValType>::operator+(const ValType &val)
+template <class ValType> template <class E> // присваивание выражения
+typename enable_if<IsExprNode<E, 1>::value, TVector<ValType>&>::type
+TVector<ValType>::operator=(const E &e)
 {
-	TVector<ValType> a(Size, StartIndex);
-	for (int i = 0; i < Size; i++)
-		a.pVector[i] = pVector[i] + val;
-	return a;
+	if (Size != e.GetSize())
+	{
+		if (!OwnMemory)
+			throw "Error";
+		TVector<ValType> a(e); // e может ссылаться на *this
+		return *this = move(a);
+	}
+	if (OwnMemory)
+		StartIndex = e.GetStartIndex();
+	Detach();
+	EvalExpr(pVector, e, Size); // поэлементно, поэтому совпадение *this
+	                            // с операндом e безопасно
+	return *this;
 } /*-------------------------------------------------------------------------*/
 
-template <class ValType> // вычесть скаляр
-TVector<ValType> TVector<ValType>::operator-(const ValType &val)
+template <class ValType> // перемещающее присваивание
+TVector<ValType>& TVector<ValType>::operator=(TVector &&v)
 {
-	TVector<ValType> a(Size, StartIndex);
-	for (int i = 0; i < Size; i++)
-		a.pVector[i] = pVector[i] - val;
-	return a;
+	if ((!OwnMemory) || (!v.OwnMemory))
+		return *this = static_cast<const TVector&>(v);
+	if (this != &v)
+	{
+		swap(pVector, v.pVector);
+		swap(Size, v.Size);
+		swap(pRefs, v.pRefs);
+		StartIndex = v.StartIndex;
+	}
+	return *this;
 } /*-------------------------------------------------------------------------*/
 
-template <class ValType> // умножить на скаляр
-TVector<ValType> TVector<ValType>::operator*(const ValType &val)
+template <class ValType> template <class E> // сложение на месте
+typename enable_if<TExprTraits<E>::Kind == 1, TVector<ValType>&>::type
+TVector<ValType>::operator+=(const E &e)
 {
-	TVector<ValType> a(Size, StartIndex);
-	for (int i = 0; i < Size; i++)
-		a.pVector[i] = pVector[i] * val;
-	return a;
+	if constexpr (is_same<E, TScalarExpr<TVector, TOpMul> >::value)
+		return Axpy(e.Value(), e.Left()); // v += x * a - одним проходом ядра Axpy
+	else
+	{
+		Detach();
+		EvalExpr(pVector, TBinExpr<TVector, E, TOpAdd>(*this, e), Size);
+		return *this;
+	}
 } /*-------------------------------------------------------------------------*/
 
-template <class ValType> // сложение
-TVector<ValType> TVector<ValType>::operator+(const TVector<ValType> &v)
+template <class ValType> template <class E> // вычитание на месте
+typename enable_if<TExprTraits<E>::Kind == 1, TVector<ValType>&>::type
+TVector<ValType>::operator-=(const E &e)
 {
-	if (Size != v.Size)
-		throw "Error";
-	TVector<ValType> a(Size, StartIndex);
-	for (int i = 0; i < Size; i++)
-		a.pVector[i] = pVector[i] + v.pVector[i];
-	return a;
+	if constexpr (is_same<E, TScalarExpr<TVector, TOpMul> >::value)
+		return Axpy(ValType(0) - e.Value(), e.Left());
+	else
+	{
+		Detach();
+		EvalExpr(pVector, TBinExpr<TVector, E, TOpSub>(*this, e), Size);
+		return *this;
+	}
 } /*-------------------------------------------------------------------------*/
 
-template <class ValType> // вычитание
-TVector<ValType> TVector<ValType>::operator-(const TVector<ValType> &v)
+template <class ValType> // умножение на скаляр на месте
+TVector<ValType>& TVector<ValType>::operator*=(const ValType &val)
 {
-	if (Size != v.Size)
+	Detach();
+	EvalExpr(pVector, TScalarExpr<TVector, TOpMul>(*this, val), Size);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // *this += alpha * x
+TVector<ValType>& TVector<ValType>::Axpy(const ValType &alpha, const TVector &x)
+{
+	if (Size != x.Size)
 		throw "Error";
-	TVector<ValType> a(Size, StartIndex);
-	for (int i = 0; i < Size; i++)
-		a.pVector[i] = pVector[i] - v.pVector[i];
-	return a;
+	Detach();
+	AxpyRange(pVector, alpha, x.pVector, Size);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // прибавить скаляр (временный вектор)
+TVector<ValType> TVector<ValType>::operator+(const ValType &val) &&
+{
+	if (!OwnMemory)
+		return static_cast<TVector&>(*this) + val;
+	Detach();
+	EvalExpr(pVector, TScalarExpr<TVector, TOpAdd>(*this, val), Size);
+	return move(*this);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // вычесть скаляр (временный вектор)
+TVector<ValType> TVector<ValType>::operator-(const ValType &val) &&
+{
+	if (!OwnMemory)
+		return static_cast<TVector&>(*this) - val;
+	Detach();
+	EvalExpr(pVector, TScalarExpr<TVector, TOpSub>(*this, val), Size);
+	return move(*this);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножить на скаляр (временный вектор)
+TVector<ValType> TVector<ValType>::operator*(const ValType &val) &&
+{
+	if (!OwnMemory)
+		return static_cast<TVector&>(*this) * val;
+	Detach();
+	EvalExpr(pVector, TScalarExpr<TVector, TOpMul>(*this, val), Size);
+	return move(*this);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сложение (временный правый операнд)
+template <class V>
+typename enable_if<is_same<V, TVector<ValType> >::value, TVector<ValType> >::type
+TVector<ValType>::operator+(V &&v) &
+{
+	if (!v.OwnMemory)
+		return *this + static_cast<const TVector&>(v);
+	v.Detach();
+	EvalExpr(v.pVector, TBinExpr<TVector, TVector, TOpAdd>(*this, v), Size);
+	v.StartIndex = StartIndex;
+	return move(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сложение (временный левый операнд)
+TVector<ValType> TVector<ValType>::operator+(const TVector<ValType> &v) &&
+{
+	if (!OwnMemory)
+		return static_cast<TVector&>(*this) + v;
+	Detach();
+	EvalExpr(pVector, TBinExpr<TVector, TVector, TOpAdd>(*this, v), Size);
+	return move(*this);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // вычитание (временный правый операнд)
+template <class V>
+typename enable_if<is_same<V, TVector<ValType> >::value, TVector<ValType> >::type
+TVector<ValType>::operator-(V &&v) &
+{
+	if (!v.OwnMemory)
+		return *this - static_cast<const TVector&>(v);
+	v.Detach();
+	EvalExpr(v.pVector, TBinExpr<TVector, TVector, TOpSub>(*this, v), Size);
+	v.StartIndex = StartIndex;
+	return move(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // вычитание (временный левый операнд)
+TVector<ValType> TVector<ValType>::operator-(const TVector<ValType> &v) &&
+{
+	if (!OwnMemory)
+		return static_cast<TVector&>(*this) - v;
+	Detach();
+	EvalExpr(pVector, TBinExpr<TVector, TVector, TOpSub>(*this, v), Size);
+	return move(*this);
 } /*-------------------------------------------------------------------------*/
 
 template <class ValType> // скалярное произведение
-ValType TVector<ValType>::operator*(const TVector<ValType> &v)
+template <class V>
+typename enable_if<is_same<V, TVector<ValType> >::value, ValType>::type
+TVector<ValType>::operator*(const V &v) const
 {
 	if (Size != v.Size)
 		throw "Error";
+	if constexpr (TSimdSupported<ValType>::value)
+		return SimdKernels<ValType>().Dot(pVector, v.pVector, Size);
 	ValType a = 0;
 	for (int i = 0; i < Size; i++)
 		a = a + (pVector[i] * v.pVector[i]);
@@ -195,23 +676,370 @@ ValType TVector<ValType>::operator*(const TVector<ValType> &v)
 } /*-------------------------------------------------------------------------*/
 
 
+  // Ленивые выражения
+  // a + b - c * k строит дерево узлов TBinExpr/TScalarExpr, хранящих ссылки
+  // на векторы (матрицы); дерево вычисляется одним проходом при присваивании,
+  // поэтому каждый операнд читается один раз, а результат пишется один раз.
+  // Размеры операндов проверяются при построении узла.
+
+template <class ValType>
+struct TExprTraits<TVector<ValType> >
+{
+	static const int Kind = 1;
+	static const bool Leaf = true;
+	typedef ValType Elem;
+	static const ValType& Get(const TVector<ValType> &v, int k) { return v.pVector[k]; }
+	static const ValType* Data(const TVector<ValType> &v) { return v.pVector; }
+	static int Length(const TVector<ValType> &v) { return v.Size; }
+};
+
+template <class ValType>
+struct TExprTraits<TMatrix<ValType> >
+{
+	static const int Kind = 2;
+	static const bool Leaf = true;
+	typedef ValType Elem;
+	static const ValType& Get(const TMatrix<ValType> &mt, int k) { return mt.pElem[k]; }
+	static const ValType* Data(const TMatrix<ValType> &mt) { return mt.pElem; }
+	static int Length(const TMatrix<ValType> &mt) { return mt.GetPackedSize(); }
+};
+
+// Узлы хранят векторы и матрицы по ссылке, вложенные узлы - по значению
+template <class E>
+struct TExprRef
+{
+	typedef typename conditional<TExprTraits<E>::Leaf, const E&, const E>::type Type;
+};
+
+struct TOpAdd { template <class A, class B> static A Apply(const A &a, const B &b) { return a + b; } };
+struct TOpSub { template <class A, class B> static A Apply(const A &a, const B &b) { return a - b; } };
+struct TOpMul { template <class A, class B> static A Apply(const A &a, const B &b) { return a * b; } };
+
+// Поэлементная операция над двумя операндами одного вида
+template <class L, class R, class Op>
+class TBinExpr
+{
+	typename TExprRef<L>::Type l;
+	typename TExprRef<R>::Type r;
+public:
+	typedef typename TExprTraits<L>::Elem Elem;
+	static const int Kind = TExprTraits<L>::Kind;
+
+	TBinExpr(const L &a, const R &b) : l(a), r(b)
+	{
+		if (l.GetSize() != r.GetSize())
+			throw "Error";
+	}
+	int GetSize() const { return l.GetSize(); }
+	int GetStartIndex() const { return l.GetStartIndex(); }
+	int Length() const { return TExprTraits<L>::Length(l); }
+	const L& Left() const { return l; }
+	const R& Right() const { return r; }
+	Elem Get(int k) const
+	{
+		return Op::Apply(Elem(TExprTraits<L>::Get(l, k)), TExprTraits<R>::Get(r, k));
+	}
+};
+
+// Поэлементная операция операнда со скаляром
+template <class L, class Op>
+class TScalarExpr
+{
+public:
+	typedef typename TExprTraits<L>::Elem Elem;
+	static const int Kind = TExprTraits<L>::Kind;
+private:
+	typename TExprRef<L>::Type l;
+	Elem val;
+public:
+	TScalarExpr(const L &a, const Elem &v) : l(a), val(v) {}
+	int GetSize() const { return l.GetSize(); }
+	int GetStartIndex() const { return l.GetStartIndex(); }
+	int Length() const { return TExprTraits<L>::Length(l); }
+	const L& Left() const { return l; }
+	const Elem& Value() const { return val; }
+	Elem Get(int k) const { return Op::Apply(Elem(TExprTraits<L>::Get(l, k)), val); }
+};
+
+template <class L, class R, class Op>
+struct TExprTraits<TBinExpr<L, R, Op> >
+{
+	static const int Kind = TExprTraits<L>::Kind;
+	static const bool Leaf = false;
+	typedef typename TExprTraits<L>::Elem Elem;
+	static Elem Get(const TBinExpr<L, R, Op> &e, int k) { return e.Get(k); }
+	static int Length(const TBinExpr<L, R, Op> &e) { return e.Length(); }
+};
+
+template <class L, class Op>
+struct TExprTraits<TScalarExpr<L, Op> >
+{
+	static const int Kind = TExprTraits<L>::Kind;
+	static const bool Leaf = false;
+	typedef typename TExprTraits<L>::Elem Elem;
+	static Elem Get(const TScalarExpr<L, Op> &e, int k) { return e.Get(k); }
+	static int Length(const TScalarExpr<L, Op> &e) { return e.Length(); }
+};
+
+// Операнд хранит элементы подряд, TExprTraits<E>::Data - указатель на них
+// (векторы, матрицы и непрерывные представления, см. utview.h)
+template <class E>
+struct IsDenseOperand : integral_constant<bool, TExprTraits<E>::Leaf> {};
+
+// Узел над вектором (матрицей) с элементами ValType можно вычислить ядром
+// utsimd.h, если его операнды хранят элементы ValType подряд
+template <class ValType, class E>
+struct IsSimdLeaf : integral_constant<bool, TSimdSupported<ValType>::value &&
+	IsDenseOperand<E>::value && is_same<typename TExprTraits<E>::Elem, ValType>::value> {};
+
+// Вычисление элементов [k0, k1) выражения в буфер dst
+template <class ValType, class E>
+void EvalExprRange(ValType *dst, const E &e, int k0, int k1)
+{
+	for (int k = k0; k < k1; k++)
+		dst[k] = e.Get(k);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, class L, class R, class Op>
+void EvalExprRange(ValType *dst, const TBinExpr<L, R, Op> &e, int k0, int k1)
+{
+	if constexpr (IsSimdLeaf<ValType, L>::value && IsSimdLeaf<ValType, R>::value &&
+		!is_same<Op, TOpMul>::value)
+	{
+		const TSimdKernels<ValType> &k = SimdKernels<ValType>();
+		(is_same<Op, TOpAdd>::value ? k.Add : k.Sub)(dst + k0,
+			TExprTraits<L>::Data(e.Left()) + k0, TExprTraits<R>::Data(e.Right()) + k0, k1 - k0);
+	}
+	else
+		for (int k = k0; k < k1; k++)
+			dst[k] = e.Get(k);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType, class L, class Op>
+void EvalExprRange(ValType *dst, const TScalarExpr<L, Op> &e, int k0, int k1)
+{
+	if constexpr (IsSimdLeaf<ValType, L>::value)
+	{
+		const TSimdKernels<ValType> &k = SimdKernels<ValType>();
+		(is_same<Op, TOpAdd>::value ? k.AddScalar : is_same<Op, TOpSub>::value ?
+			k.SubScalar : k.MulScalar)(dst + k0, TExprTraits<L>::Data(e.Left()) + k0,
+			e.Value(), k1 - k0);
+	}
+	else
+		for (int k = k0; k < k1; k++)
+			dst[k] = e.Get(k);
+} /*-------------------------------------------------------------------------*/
+
+// Вычисление выражения в буфер dst из n элементов; матричные выражения
+// (Kind >= 2) делятся между потоками на части с равным числом элементов
+template <class ValType, class E>
+void EvalExpr(ValType *dst, const E &e, int n)
+{
+	if constexpr (TExprTraits<E>::Kind >= 2)
+		ParallelRange<ValType>(n, [&](int k0, int k1) { EvalExprRange(dst, e, k0, k1); });
+	else
+		EvalExprRange(dst, e, 0, n);
+} /*-------------------------------------------------------------------------*/
+
+// L и R - операнды одного вида (вектор с вектором, матрица с матрицей)
+template <class L, class R>
+struct IsExprPair : integral_constant<bool, (TExprTraits<L>::Kind != 0) &&
+	(TExprTraits<L>::Kind == TExprTraits<R>::Kind)> {};
+
+template <class L, class R> // сложение
+typename enable_if<IsExprPair<L, R>::value, TBinExpr<L, R, TOpAdd> >::type
+operator+(const L &l, const R &r)
+{
+	return TBinExpr<L, R, TOpAdd>(l, r);
+} /*-------------------------------------------------------------------------*/
+
+template <class L, class R> // вычитание
+typename enable_if<IsExprPair<L, R>::value, TBinExpr<L, R, TOpSub> >::type
+operator-(const L &l, const R &r)
+{
+	return TBinExpr<L, R, TOpSub>(l, r);
+} /*-------------------------------------------------------------------------*/
+
+template <class L> // прибавить скаляр
+typename enable_if<TExprTraits<L>::Kind == 1, TScalarExpr<L, TOpAdd> >::type
+operator+(const L &l, const typename TExprTraits<L>::Elem &val)
+{
+	return TScalarExpr<L, TOpAdd>(l, val);
+} /*-------------------------------------------------------------------------*/
+
+template <class L> // вычесть скаляр
+typename enable_if<TExprTraits<L>::Kind == 1, TScalarExpr<L, TOpSub> >::type
+operator-(const L &l, const typename TExprTraits<L>::Elem &val)
+{
+	return TScalarExpr<L, TOpSub>(l, val);
+} /*-------------------------------------------------------------------------*/
+
+template <class L> // умножить на скаляр
+typename enable_if<TExprTraits<L>::Kind != 0, TScalarExpr<L, TOpMul> >::type
+operator*(const L &l, const typename TExprTraits<L>::Elem &val)
+{
+	return TScalarExpr<L, TOpMul>(l, val);
+} /*-------------------------------------------------------------------------*/
+
+template <class L, class R> // скалярное произведение (хотя бы один операнд - выражение)
+typename enable_if<IsExprPair<L, R>::value && (TExprTraits<L>::Kind == 1) &&
+	!(TExprTraits<L>::Leaf && TExprTraits<R>::Leaf), typename TExprTraits<L>::Elem>::type
+operator*(const L &l, const R &r)
+{
+	typedef typename TExprTraits<L>::Elem Elem;
+	if (l.GetSize() != r.GetSize())
+		throw "Error";
+	if constexpr (IsSimdLeaf<Elem, L>::value && IsSimdLeaf<Elem, R>::value)
+		return SimdKernels<Elem>().Dot(TExprTraits<L>::Data(l), TExprTraits<R>::Data(r),
+			TExprTraits<L>::Length(l));
+	Elem a = 0;
+	for (int i = 0; i < TExprTraits<L>::Length(l); i++)
+		a = a + (TExprTraits<L>::Get(l, i) * TExprTraits<R>::Get(r, i));
+	return a;
+} /*-------------------------------------------------------------------------*/
+
+template <class L, class R> // сравнение (хотя бы один операнд - выражение)
+typename enable_if<IsExprPair<L, R>::value &&
+	!(TExprTraits<L>::Leaf && TExprTraits<R>::Leaf), bool>::type
+operator==(const L &l, const R &r)
+{
+	if (l.GetSize() != r.GetSize())
+		return false;
+	for (int k = 0; k < TExprTraits<L>::Length(l); k++)
+		if (TExprTraits<L>::Get(l, k) != TExprTraits<R>::Get(r, k))
+			return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class L, class R> // сравнение
+typename enable_if<IsExprPair<L, R>::value &&
+	!(TExprTraits<L>::Leaf && TExprTraits<R>::Leaf), bool>::type
+operator!=(const L &l, const R &r)
+{
+	return !(l == r);
+} /*-------------------------------------------------------------------------*/
+
+template <class E> // вывод выражения
+typename enable_if<IsExprNode<E, 1>::value || IsExprNode<E, 2>::value, ostream&>::type
+operator<<(ostream &out, const E &e)
+{
+	typedef typename TExprTraits<E>::Elem Elem;
+	typedef typename conditional<TExprTraits<E>::Kind == 1,
+		TVector<Elem>, TMatrix<Elem> >::type Result;
+	return out << Result(e);
+} /*-------------------------------------------------------------------------*/
+
+
   // Верхнетреугольная матрица
+  // Все n(n+1)/2 элементов хранятся построчно в одном выровненном буфере pElem,
+  // строки базового вектора - представления TVector над этим буфером;
+  // размер задается при выполнении (TMatrix<ValType> = TMatrix<ValType, 0>)
 template <class ValType>
-class TMatrix : public TVector<TVector<ValType> >
+class TMatrix<ValType, 0> : public TVector<TVector<ValType> >
 {
+protected:
+	using TVector<TVector<ValType> >::pVector;
+	using TVector<TVector<ValType> >::Size;
+	using TVector<TVector<ValType> >::pRefs; // ссылки на pElem, pOffset и строки (UTMATRIX_COW)
+
+	ValType *pElem; // упакованные элементы
+	int *pOffset;   // смещения строк в pElem, pOffset[Size] = Size*(Size+1)/2
+	bool OwnElem;   // false - pElem принадлежит не матрице (см. TMappedMatrix)
+
+	void Allocate(int s, ValType *p = nullptr); // разместить таблицу смещений и строки,
+	                               // буфер - если не задан внешний буфер p
+	void Release();                // освободить память
+	void Swap(TMatrix &mt);        // обмен содержимым
+	TMatrix(ValType *p, int s);    // представление над чужим упакованным буфером
+	void Detach();                 // собственный буфер перед записью
+	void Leak() { Detach(); CowLeak(pRefs); } // собственный буфер перед выдачей ссылки
+	static TVector<TVector<ValType> > NewVectors(int m, int n); // m векторов размера n
+
+	template <class E> friend struct TExprTraits;
+	template <class T> friend class TMappedMatrix;
+	template <class T> friend class TTransposedView;
+	friend class TVector<TVector<ValType> >; // Detach при записи через базовый класс
 public:
 	TMatrix(int s = 10);
 	TMatrix(const TMatrix &mt);                    // копирование
+	TMatrix(TMatrix &&mt) noexcept;                // перемещение
 	TMatrix(const TVector<TVector<ValType> > &mt); // преобразование типа
+	template <class E, class = typename enable_if<IsExprNode<E, 2>::value>::type>
+	TMatrix(const E &e);                           // вычисление выражения
+	~TMatrix();
+	int GetPackedSize() const { return Size * (Size + 1) / 2; } // число хранимых элементов
+	int GetRowOffset(int i) const { return pOffset[i]; } // начало строки i в буфере
+	const int* GetRowOffsets() const { return pOffset; } // таблица начал строк
+	ValType* GetData() { Leak(); return pElem; }         // упакованный буфер
+	const ValType* GetData() const { return pElem; }
+	TVector<ValType>& operator[](int pos)                // строка
+	{
+		Leak();
+		return TVector<TVector<ValType> >::operator[](pos);
+	}
+	const TVector<ValType>& operator[](int pos) const
+	{
+		return TVector<TVector<ValType> >::operator[](pos);
+	}
+	TVector<ValType>& at_unchecked(int pos) { Leak(); return pVector[pos]; }
+	const TVector<ValType>& at_unchecked(int pos) const { return pVector[pos]; }
+
+	// Итераторы STL: begin()/end() - по всем хранимым элементам подряд
+	// (строка за строкой, элемент (i, j) - begin()[GetRowOffset(i) + j - i]),
+	// Rows() - по строкам-векторам (у строки i индексы i..n-1)
+	typedef ValType value_type;
+	typedef ValType* iterator;
+	typedef const ValType* const_iterator;
+	typedef TVector<ValType>* row_iterator;
+	typedef const TVector<ValType>* const_row_iterator;
+	iterator begin() { Leak(); return pElem; }
+	iterator end() { Leak(); return pElem + GetPackedSize(); }
+	const_iterator begin() const { return pElem; }
+	const_iterator end() const { return pElem + GetPackedSize(); }
+	const_iterator cbegin() const { return pElem; }
+	const_iterator cend() const { return pElem + GetPackedSize(); }
+	TRange<row_iterator> Rows() { Leak(); return TRange<row_iterator>(pVector, pVector + Size); }
+	TRange<const_row_iterator> Rows() const { return TRange<const_row_iterator>(pVector, pVector + Size); }
+
 	bool operator==(const TMatrix &mt) const;      // сравнение
 	bool operator!=(const TMatrix &mt) const;      // сравнение
 	TMatrix& operator= (const TMatrix &mt);        // присваивание
-	TMatrix  operator+ (const TMatrix &mt);        // сложение
-	TMatrix  operator- (const TMatrix &mt);        // вычитание
+	TMatrix& operator= (TMatrix &&mt) noexcept;    // перемещающее присваивание
+	template <class E>
+	typename enable_if<IsExprNode<E, 2>::value, TMatrix&>::type
+		operator= (const E &e);                    // вычисление выражения
+	template <class E>                             // сложение и вычитание на месте
+	typename enable_if<TExprTraits<E>::Kind == 2, TMatrix&>::type
+		operator+= (const E &e);
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 2, TMatrix&>::type
+		operator-= (const E &e);
+	TMatrix& operator*= (const ValType &val);      // умножение на скаляр на месте
+	TMatrix& Axpy(const ValType &alpha, const TMatrix &mt); // *this += alpha * mt
+
+	// m + n и m - n для матриц-переменных строят ленивые выражения;
+	// ниже - операции над временными матрицами
+	template <class M>                             // результат - в памяти временного mt
+	typename enable_if<is_same<M, TMatrix>::value, TMatrix>::type operator+ (M &&mt) &;
+	template <class M>
+	typename enable_if<is_same<M, TMatrix>::value, TMatrix>::type operator- (M &&mt) &;
+	TMatrix  operator+ (const TMatrix &mt) &&;     // результат - в памяти *this
+	TMatrix  operator- (const TMatrix &mt) &&;
+	template <class M>                             // умножение (блочное, см. TriMulPacked)
+	typename enable_if<is_same<M, TMatrix>::value, TMatrix>::type
+		operator* (const M &mt) const;
+	template <class V>                             // умножение на вектор
+	typename enable_if<is_same<V, TVector<ValType> >::value, TVector<ValType> >::type
+		operator* (const V &v) const;
+	TVector<ValType> MulTransposed(const TVector<ValType> &v) const; // U^T * v
+	TVector<ValType> Solve(const TVector<ValType> &b) const;         // решение Ux = b
+	TVector<TVector<ValType> > Solve(const TVector<TVector<ValType> > &b) const; // для
+	                                               // нескольких правых частей b[0], b[1], ...
 
 												   // ввод / вывод
 	friend istream& operator>>(istream &in, TMatrix &mt)
 	{
+		mt.Detach();
 		for (int i = 0; i < mt.Size; i++)
 			in >> mt.pVector[i];
 		return in;
@@ -219,32 +1047,158 @@ public:
 	friend ostream & operator<<(ostream &out, const TMatrix &mt)
 	{
 		for (int i = 0; i < mt.Size; i++)
-			out << mt.pVector[i] << endl;
+			out << mt.pVector[i] << '\n'; // без сброса потока после каждой строки
 		return out;
 	}
 };
 
 template <class ValType>
-TMatrix<ValType>::TMatrix(int s) : TVector<TVector<ValType> >(s)
+void TMatrix<ValType>::Allocate(int s, ValType *p)
+{
+	pOffset = new int[s + 1];
+	pOffset[0] = 0;
+	for (int i = 0; i < s; i++)
+		pOffset[i + 1] = pOffset[i] + (s - i);
+	OwnElem = (p == nullptr);
+	try
+	{
+		pElem = OwnElem ? AllocAligned<ValType>(pOffset[s]) : p;
+	}
+	catch (...)
+	{
+		delete[] pOffset;
+		throw;
+	}
+	pVector = static_cast<TVector<ValType>*>(::operator new(s * sizeof(TVector<ValType>)));
+	for (int i = 0; i < s; i++)
+		new (pVector + i) TVector<ValType>(pElem + pOffset[i], s - i, i);
+	Size = s;
+	pRefs = OwnElem ? CowNew() : nullptr;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // m векторов размера n: буфер каждого выделяется один раз
+TVector<TVector<ValType> > TMatrix<ValType>::NewVectors(int m, int n)
+{
+	TVector<TVector<ValType> > r(nullptr, 0, 0);
+	r.OwnMemory = true;
+	r.pRefs = CowNew();
+	r.pVector = AllocAligned<TVector<ValType> >(m, n);
+	r.Size = m;
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void TMatrix<ValType>::Release()
+{
+	if (!CowRelease(pRefs)) // память нужна другим копиям
+		return;
+	for (int i = 0; i < Size; i++)
+		pVector[i].~TVector<ValType>();
+	::operator delete(pVector);
+	if (OwnElem)
+		FreeAligned(pElem, GetPackedSize());
+	delete[] pOffset;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void TMatrix<ValType>::Swap(TMatrix<ValType> &mt)
+{
+	swap(pVector, mt.pVector);
+	swap(Size, mt.Size);
+	swap(pElem, mt.pElem);
+	swap(pOffset, mt.pOffset);
+	swap(OwnElem, mt.OwnElem);
+	swap(pRefs, mt.pRefs);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // собственный буфер перед записью
+void TMatrix<ValType>::Detach()
+{
+	if (!CowShared(pRefs))
+		return;
+	TMatrix<ValType> m(Size);
+	copy_n(pElem, GetPackedSize(), m.pElem);
+	Swap(m);
+	CowCounters()[1].fetch_add(1, memory_order_relaxed);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TMatrix<ValType>::TMatrix(int s) : TVector<TVector<ValType> >(nullptr, 0, 0)
 {
 	if ((s > MAX_MATRIX_SIZE) || (s < 0))
 		throw "Negative size";
-	for (int i = 0; i < s; i++)
-		pVector[i] = TVector<ValType>(s - i, i);
+	Allocate(s);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // представление над чужим упакованным буфером
+TMatrix<ValType>::TMatrix(ValType *p, int s) : TVector<TVector<ValType> >(nullptr, 0, 0)
+{
+	Allocate(s, p);
 } /*-------------------------------------------------------------------------*/
 
 template <class ValType> // конструктор копирования
 TMatrix<ValType>::TMatrix(const TMatrix<ValType> &mt) :
-	TVector<TVector<ValType> >(mt) {}
+	TVector<TVector<ValType> >(nullptr, 0, 0)
+{
+	if (CowShareable(mt.pRefs)) // общие строки и буфер до первой записи (UTMATRIX_COW)
+	{
+		pVector = mt.pVector;
+		Size = mt.Size;
+		pElem = mt.pElem;
+		pOffset = mt.pOffset;
+		OwnElem = true;
+		pRefs = CowShare(mt.pRefs);
+		return;
+	}
+	Allocate(mt.Size);
+	copy_n(mt.pElem, GetPackedSize(), pElem);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // конструктор перемещения
+TMatrix<ValType>::TMatrix(TMatrix<ValType> &&mt) noexcept :
+	TVector<TVector<ValType> >(nullptr, 0, 0), pElem(nullptr), pOffset(nullptr), OwnElem(true)
+{
+	Swap(mt);
+} /*-------------------------------------------------------------------------*/
 
 template <class ValType> // конструктор преобразования типа
 TMatrix<ValType>::TMatrix(const TVector<TVector<ValType> > &mt) :
-	TVector<TVector<ValType> >(mt) {}
+	TVector<TVector<ValType> >(nullptr, 0, 0)
+{
+	int s = mt.Size;
+	if (s > MAX_MATRIX_SIZE)
+		throw "Negative size";
+	for (int i = 0; i < s; i++)
+		if ((mt.pVector[i].Size != s - i) || (mt.pVector[i].StartIndex != i))
+			throw "Not upper triangular";
+	Allocate(s);
+	for (int i = 0; i < s; i++)
+		for (int j = 0; j < s - i; j++)
+			pElem[pOffset[i] + j] = mt.pVector[i].pVector[j];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E, class> // вычисление выражения
+TMatrix<ValType>::TMatrix(const E &e) : TVector<TVector<ValType> >(nullptr, 0, 0)
+{
+	Allocate(e.GetSize());
+	EvalExpr(pElem, e, GetPackedSize());
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TMatrix<ValType>::~TMatrix()
+{
+	Release();
+} /*-------------------------------------------------------------------------*/
 
 template <class ValType> // сравнение
 bool TMatrix<ValType>::operator==(const TMatrix<ValType> &mt) const
 {
-	return TVector<TVector<ValType> > :: operator==(mt);
+	if (Size != mt.Size)
+		return false;
+	for (int k = 0; k < GetPackedSize(); k++)
+		if (pElem[k] != mt.pElem[k])
+			return false;
+	return true;
 } /*-------------------------------------------------------------------------*/
 
 template <class ValType> // сравнение
@@ -256,20 +1210,203 @@ bool TMatrix<ValType>::operator!=(const TMatrix<ValType> &mt) const
 template <class ValType> // присваивание
 TMatrix<ValType>& TMatrix<ValType>::operator=(const TMatrix<ValType> &mt)
 {
-	TVector<TVector<ValType> > :: operator=(mt);
+	if (this != &mt)
+	{
+		if ((Size != mt.Size) || (OwnElem && CowShareable(mt.pRefs)))
+		{
+			TMatrix<ValType> tmp(mt); // при UTMATRIX_COW - без копирования, если буфер разделяем
+			Swap(tmp);
+		}
+		else
+		{
+			Detach();
+			copy_n(mt.pElem, GetPackedSize(), pElem);
+		}
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // присваивание выражения
+typename enable_if<IsExprNode<E, 2>::value, TMatrix<ValType>&>::type
+TMatrix<ValType>::operator=(const E &e)
+{
+	if (Size != e.GetSize())
+	{
+		TMatrix<ValType> a(e);
+		Swap(a);
+	}
+	else
+	{
+		Detach();
+		EvalExpr(pElem, e, GetPackedSize());
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещающее присваивание
+TMatrix<ValType>& TMatrix<ValType>::operator=(TMatrix<ValType> &&mt) noexcept
+{
+	Swap(mt);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // сложение на месте
+typename enable_if<TExprTraits<E>::Kind == 2, TMatrix<ValType>&>::type
+TMatrix<ValType>::operator+=(const E &e)
+{
+	if constexpr (is_same<E, TScalarExpr<TMatrix, TOpMul> >::value)
+		return Axpy(e.Value(), e.Left());
+	else
+	{
+		Detach();
+		EvalExpr(pElem, TBinExpr<TMatrix, E, TOpAdd>(*this, e), GetPackedSize());
+		return *this;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // вычитание на месте
+typename enable_if<TExprTraits<E>::Kind == 2, TMatrix<ValType>&>::type
+TMatrix<ValType>::operator-=(const E &e)
+{
+	if constexpr (is_same<E, TScalarExpr<TMatrix, TOpMul> >::value)
+		return Axpy(ValType(0) - e.Value(), e.Left());
+	else
+	{
+		Detach();
+		EvalExpr(pElem, TBinExpr<TMatrix, E, TOpSub>(*this, e), GetPackedSize());
+		return *this;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение на скаляр на месте
+TMatrix<ValType>& TMatrix<ValType>::operator*=(const ValType &val)
+{
+	Detach();
+	EvalExpr(pElem, TScalarExpr<TMatrix, TOpMul>(*this, val), GetPackedSize());
 	return *this;
 } /*-------------------------------------------------------------------------*/
 
-template <class ValType> // сложение
-TMatrix<ValType> TMatrix<ValType>::operator+(const TMatrix<ValType> &mt)
+template <class ValType> // *this += alpha * mt
+TMatrix<ValType>& TMatrix<ValType>::Axpy(const ValType &alpha, const TMatrix &mt)
+{
+	if (Size != mt.Size)
+		throw "Error";
+	Detach();
+	ParallelRange<ValType>(GetPackedSize(), [&](int k0, int k1)
+	{
+		AxpyRange(pElem + k0, alpha, mt.pElem + k0, k1 - k0);
+	});
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сложение (временный правый операнд)
+template <class M>
+typename enable_if<is_same<M, TMatrix<ValType> >::value, TMatrix<ValType> >::type
+TMatrix<ValType>::operator+(M &&mt) &
+{
+	mt.Detach();
+	EvalExpr(mt.pElem, TBinExpr<TMatrix, TMatrix, TOpAdd>(*this, mt), GetPackedSize());
+	return move(mt);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сложение (временный левый операнд)
+TMatrix<ValType> TMatrix<ValType>::operator+(const TMatrix<ValType> &mt) &&
+{
+	Detach();
+	EvalExpr(pElem, TBinExpr<TMatrix, TMatrix, TOpAdd>(*this, mt), GetPackedSize());
+	return move(*this);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // вычитание (временный правый операнд)
+template <class M>
+typename enable_if<is_same<M, TMatrix<ValType> >::value, TMatrix<ValType> >::type
+TMatrix<ValType>::operator-(M &&mt) &
+{
+	mt.Detach();
+	EvalExpr(mt.pElem, TBinExpr<TMatrix, TMatrix, TOpSub>(*this, mt), GetPackedSize());
+	return move(mt);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // вычитание (временный левый операнд)
+TMatrix<ValType> TMatrix<ValType>::operator-(const TMatrix<ValType> &mt) &&
+{
+	Detach();
+	EvalExpr(pElem, TBinExpr<TMatrix, TMatrix, TOpSub>(*this, mt), GetPackedSize());
+	return move(*this);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение
+template <class M>
+typename enable_if<is_same<M, TMatrix<ValType> >::value, TMatrix<ValType> >::type
+TMatrix<ValType>::operator*(const M &mt) const
+{
+	if (Size != mt.Size)
+		throw "Error";
+	TMatrix<ValType> c(Size);
+	fill_n(c.pElem, GetPackedSize(), ValType(0));
+	TriMulPacked(pElem, mt.pElem, c.pElem, pOffset, Size);
+	return c;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение на вектор
+template <class V>
+typename enable_if<is_same<V, TVector<ValType> >::value, TVector<ValType> >::type
+TMatrix<ValType>::operator*(const V &v) const
 {
-	return TVector<TVector<ValType> > :: operator+(mt);
+	if (Size != v.Size)
+		throw "Error";
+	TVector<ValType> y(Size);
+	TriMatVecPacked(pElem, pOffset, Size, v.pVector, y.pVector);
+	return y;
 } /*-------------------------------------------------------------------------*/
 
-template <class ValType> // вычитание
-TMatrix<ValType> TMatrix<ValType>::operator-(const TMatrix<ValType> &mt)
+template <class ValType> // умножение транспонированной матрицы на вектор
+TVector<ValType> TMatrix<ValType>::MulTransposed(const TVector<ValType> &v) const
 {
-	return TVector<TVector<ValType> > :: operator-(mt);
+	if (Size != v.Size)
+		throw "Error";
+	TVector<ValType> y(Size);
+	fill_n(y.pVector, Size, ValType(0));
+	TriMatTVecPacked(pElem, pOffset, Size, v.pVector, y.pVector);
+	return y;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // решение Ux = b
+TVector<ValType> TMatrix<ValType>::Solve(const TVector<ValType> &b) const
+{
+	if (Size != b.Size)
+		throw "Error";
+	for (int i = 0; i < Size; i++)
+		if (pElem[pOffset[i]] == ValType(0))
+			throw "Singular matrix";
+	TVector<ValType> x(b);
+	x.StartIndex = 0;
+	x.Detach();
+	TriSolvePacked(pElem, pOffset, Size, x.pVector, 1);
+	return x;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // решение Ux = b для нескольких правых частей
+TVector<TVector<ValType> > TMatrix<ValType>::Solve(const TVector<TVector<ValType> > &b) const
+{
+	int m = b.Size;
+	for (int c = 0; c < m; c++)
+		if (b.pVector[c].Size != Size)
+			throw "Error";
+	for (int i = 0; i < Size; i++)
+		if (pElem[pOffset[i]] == ValType(0))
+			throw "Singular matrix";
+	unique_ptr<ValType[]> buf(new ValType[size_t(Size) * m]);
+	ValType *x = buf.get(); // правые части по строкам
+	for (int i = 0; i < Size; i++)
+		for (int c = 0; c < m; c++)
+			x[size_t(i) * m + c] = b.pVector[c].pVector[i];
+	TriSolvePacked(pElem, pOffset, Size, x, m);
+	TVector<TVector<ValType> > r = NewVectors(m, Size);
+	for (int c = 0; c < m; c++)
+		for (int i = 0; i < Size; i++)
+			r.pVector[c].pVector[i] = x[size_t(i) * m + c];
+	return r;
 } /*-------------------------------------------------------------------------*/
 
   // TVector О3 Л2 П4 С6
@@ -0,0 +1,244 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utparallel.h
+//
+// Пул потоков для поэлементных проходов по упакованным матрицам. Диапазон
+// [0, n) делится на части с равным числом элементов; так как треугольник
+// хранится одним буфером, все потоки получают одинаковую работу независимо
+// от длины строк. Проходы короче порога выполняются в вызывающем потоке.
+
+#ifndef __UTPARALLEL_H__
+#define __UTPARALLEL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const int CACHE_LINE_SIZE = 64; // байт
+
+// Границы частей ParallelRange кратны строке кэша: 64 / sizeof(ValType) элементов
+template <class ValType>
+constexpr int ParallelAlign()
+{
+	return sizeof(ValType) >= CACHE_LINE_SIZE ? 1 : int(CACHE_LINE_SIZE / sizeof(ValType));
+} /*-------------------------------------------------------------------------*/
+
+class TThreadPool
+{
+	vector<thread> Workers;
+	atomic<int> Size;               // число потоков с учетом вызывающего
+	mutex Serial;                   // задания и смена числа потоков - по очереди
+	mutex Lock;
+	condition_variable Wake, Done;
+	const function<void(int)> *Job; // текущее задание
+	int JobCount;                   // число частей задания
+	int Next;                       // следующая невыданная часть
+	int Finished;                   // число выполненных частей
+	unsigned Generation;            // номер задания
+	bool Stop;
+	exception_ptr Error;            // первое исключение из частей
+
+	static bool& InWorker()
+	{
+		static thread_local bool flag = false;
+		return flag;
+	}
+	void Work(unsigned gen); // выполнять части задания gen, пока они есть
+	void Loop();
+	void StopWorkers();
+public:
+	TThreadPool() : Size(1), Job(nullptr), JobCount(0), Next(0), Finished(0), Generation(0), Stop(false) {}
+	~TThreadPool() { StopWorkers(); }
+	static TThreadPool& Instance();
+	int GetSize() const { return Size; } // с учетом вызывающего
+	void Resize(int threads); // не из частей задания
+	void Run(int tasks, const function<void(int)> &f); // f(0), ..., f(tasks - 1)
+};
+
+inline TThreadPool& TThreadPool::Instance()
+{
+	static TThreadPool pool;
+	return pool;
+} /*-------------------------------------------------------------------------*/
+
+inline void TThreadPool::Work(unsigned gen)
+{
+	for (;;)
+	{
+		const function<void(int)> *job;
+		int t;
+		{
+			lock_guard<mutex> g(Lock);
+			if ((gen != Generation) || (Next >= JobCount))
+				return;
+			t = Next++;
+			job = Job;
+		}
+		try
+		{
+			(*job)(t);
+		}
+		catch (...)
+		{
+			lock_guard<mutex> g(Lock);
+			if (!Error)
+				Error = current_exception();
+		}
+		lock_guard<mutex> g(Lock);
+		if (++Finished == JobCount)
+			Done.notify_all();
+	}
+} /*-------------------------------------------------------------------------*/
+
+inline void TThreadPool::Loop()
+{
+	InWorker() = true;
+	unsigned seen = 0;
+	for (;;)
+	{
+		{
+			unique_lock<mutex> g(Lock);
+			Wake.wait(g, [&] { return Stop || (Generation != seen); });
+			if (Stop)
+				return;
+			seen = Generation;
+		}
+		Work(seen);
+	}
+} /*-------------------------------------------------------------------------*/
+
+inline void TThreadPool::StopWorkers()
+{
+	{
+		lock_guard<mutex> g(Lock);
+		Stop = true;
+	}
+	Wake.notify_all();
+	for (size_t i = 0; i < Workers.size(); i++)
+		Workers[i].join();
+	Workers.clear();
+	Stop = false;
+} /*-------------------------------------------------------------------------*/
+
+inline void TThreadPool::Resize(int threads)
+{
+	if (InWorker()) // из части задания: Serial занят этим заданием
+		throw "Error";
+	if (threads < 1)
+		threads = 1;
+	lock_guard<mutex> s(Serial); // дождаться окончания текущего задания
+	if (threads == GetSize())
+		return;
+	StopWorkers();
+	for (int i = 1; i < threads; i++)
+		Workers.push_back(thread(&TThreadPool::Loop, this));
+	Size = threads;
+} /*-------------------------------------------------------------------------*/
+
+inline void TThreadPool::Run(int tasks, const function<void(int)> &f)
+{
+	if ((Size == 1) || InWorker() || (tasks <= 1)) // вложенный вызов - последовательно
+	{
+		for (int t = 0; t < tasks; t++)
+			f(t);
+		return;
+	}
+	// Задания разных потоков выполняются по очереди; если Resize успел
+	// остановить потоки, все части выполнит вызывающий поток
+	lock_guard<mutex> s(Serial);
+	unsigned gen;
+	{
+		lock_guard<mutex> g(Lock);
+		Job = &f;
+		JobCount = tasks;
+		Next = 0;
+		Finished = 0;
+		Error = nullptr;
+		gen = ++Generation;
+	}
+	Wake.notify_all();
+	InWorker() = true; // вложенные вызовы из частей вызывающего потока - тоже
+	Work(gen);
+	InWorker() = false;
+	unique_lock<mutex> g(Lock);
+	Done.wait(g, [&] { return Finished == JobCount; });
+	Job = nullptr;
+	JobCount = 0;
+	if (Error)
+		rethrow_exception(Error);
+} /*-------------------------------------------------------------------------*/
+
+  // Настройки параллельного режима
+
+inline atomic<int>& ParallelCutoffRef()
+{
+	static atomic<int> cutoff(1 << 16);
+	return cutoff;
+} /*-------------------------------------------------------------------------*/
+
+// Число потоков (вместе с вызывающим); 1 - последовательный режим
+inline int GetNumThreads()
+{
+	return TThreadPool::Instance().GetSize();
+} /*-------------------------------------------------------------------------*/
+
+// Установить число потоков; 0 - по числу ядер
+inline void SetNumThreads(int threads)
+{
+	if (threads == 0)
+		threads = max(1u, thread::hardware_concurrency());
+	TThreadPool::Instance().Resize(threads);
+} /*-------------------------------------------------------------------------*/
+
+// Минимальное число элементов, при котором проход распараллеливается
+inline int GetParallelCutoff()
+{
+	return ParallelCutoffRef().load(memory_order_relaxed);
+} /*-------------------------------------------------------------------------*/
+
+inline void SetParallelCutoff(int elements)
+{
+	ParallelCutoffRef().store(max(0, elements), memory_order_relaxed);
+} /*-------------------------------------------------------------------------*/
+
+// Выполнить f(k0, k1) над частями [0, n) массива ValType с равным числом элементов
+template <class ValType, class F>
+void ParallelRange(int n, F f)
+{
+	const int align = ParallelAlign<ValType>();
+	int threads = GetNumThreads();
+	if ((threads <= 1) || (n < GetParallelCutoff()) || (n < 2 * align))
+	{
+		f(0, n);
+		return;
+	}
+	int chunk = (n + threads - 1) / threads;
+	chunk = (chunk + align - 1) / align * align;
+	int tasks = (n + chunk - 1) / chunk;
+	function<void(int)> job = [&](int t) { f(t * chunk, min(n, (t + 1) * chunk)); };
+	TThreadPool::Instance().Run(tasks, job);
+} /*-------------------------------------------------------------------------*/
+
+// Выполнить f(0), ..., f(tasks - 1); части раздаются потокам пула, если
+// общий объем работы work (в элементах) не меньше порога
+template <class F>
+void ParallelTasks(int tasks, long long work, F f)
+{
+	if ((GetNumThreads() <= 1) || (work < GetParallelCutoff()) || (tasks <= 1))
+	{
+		for (int t = 0; t < tasks; t++)
+			f(t);
+		return;
+	}
+	function<void(int)> job = [&](int t) { f(t); };
+	TThreadPool::Instance().Run(tasks, job);
+} /*-------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,216 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utpool.h
+//
+// Пул буферов для векторов и матриц, свой у каждого потока. Запрос
+// округляется вверх до размерного класса (четыре класса на каждую степень
+// двойки, перерасход не более 25%); освобожденный буфер остается в пуле
+// своего класса и выдается следующему запросу того же класса, поэтому
+// временные результаты одного размера в цикле не обращаются к malloc.
+
+#ifndef __UTPOOL_H__
+#define __UTPOOL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+const size_t POOL_ALIGNMENT = 64;      // выравнивание буферов пула (байт)
+const size_t POOL_MIN_CLASS = 64;      // наименьший размерный класс (байт)
+const int POOL_CLASSES = 4 * 40 + 1;   // классы до 2^46 байт
+const size_t POOL_CLASS_DEPTH = 4;     // буферов одного класса в запасе
+
+// Статистика пула потока
+struct TBufferPoolStats
+{
+	size_t Requests;        // запросов буферов
+	size_t Hits;            // из них выдано из пула
+	size_t RetainedBuffers; // буферов в пуле
+	size_t RetainedBytes;   // их суммарный объем (байт)
+	double HitRate() const { return Requests ? double(Hits) / Requests : 0.0; }
+};
+
+class TBufferPool
+{
+	vector<void*> Free[POOL_CLASSES]; // свободные буферы по классам
+	TBufferPoolStats Stats;
+
+	static int& State()             // 0 - не создан, 1 - работает, 2 - уничтожен
+	{
+		static thread_local int state = 0;
+		return state;
+	}
+	static void* NewBuffer(size_t bytes) { return ::operator new(bytes, align_val_t(POOL_ALIGNMENT)); }
+	static void DeleteBuffer(void *p) { ::operator delete(p, align_val_t(POOL_ALIGNMENT)); }
+public:
+	TBufferPool() : Stats() { State() = 1; }
+	~TBufferPool() { Trim(0); State() = 2; }
+	static TBufferPool* Local();                 // пул потока; nullptr при выходе из потока
+	static atomic<size_t>& Limit();              // наибольший объем пула потока (байт)
+	static int ClassOf(size_t bytes, size_t &cap); // класс и его емкость
+	static size_t CapOf(int c);                  // емкость класса c
+	void* Get(size_t bytes);
+	void Put(void *p, size_t bytes);
+	void Trim(size_t keep);                      // освободить буферы сверх keep байт
+	const TBufferPoolStats& GetStats() const { return Stats; }
+	void ResetStats() { Stats.Requests = Stats.Hits = 0; }
+};
+
+inline TBufferPool* TBufferPool::Local()
+{
+	if (State() == 2) // деструкторы статических объектов после выхода потока
+		return nullptr;
+	static thread_local TBufferPool pool;
+	return &pool;
+} /*-------------------------------------------------------------------------*/
+
+inline atomic<size_t>& TBufferPool::Limit()
+{
+	static atomic<size_t> limit(size_t(64) << 20);
+	return limit;
+} /*-------------------------------------------------------------------------*/
+
+inline int TBufferPool::ClassOf(size_t bytes, size_t &cap)
+{
+	if (bytes <= POOL_MIN_CLASS)
+	{
+		cap = POOL_MIN_CLASS;
+		return 0;
+	}
+	int e = 6;                               // 2^e < bytes <= 2^(e+1)
+	while ((size_t(2) << e) < bytes)
+		e++;
+	size_t step = size_t(1) << (e - 2);
+	size_t k = (bytes - 1 - (size_t(1) << e)) / step + 1; // 1..4
+	cap = (size_t(1) << e) + k * step;
+	return (e - 6) * 4 + int(k);
+} /*-------------------------------------------------------------------------*/
+
+inline size_t TBufferPool::CapOf(int c)
+{
+	if (c == 0)
+		return POOL_MIN_CLASS;
+	int e = 6 + (c - 1) / 4;
+	return (size_t(1) << e) + size_t((c - 1) % 4 + 1) * (size_t(1) << (e - 2));
+} /*-------------------------------------------------------------------------*/
+
+inline void* TBufferPool::Get(size_t bytes)
+{
+	size_t cap;
+	int c = ClassOf(bytes, cap);
+	Stats.Requests++;
+	if ((c < POOL_CLASSES) && !Free[c].empty())
+	{
+		void *p = Free[c].back();
+		Free[c].pop_back();
+		Stats.Hits++;
+		Stats.RetainedBuffers--;
+		Stats.RetainedBytes -= cap;
+		return p;
+	}
+	return NewBuffer(cap);
+} /*-------------------------------------------------------------------------*/
+
+inline void TBufferPool::Put(void *p, size_t bytes)
+{
+	size_t cap;
+	int c = ClassOf(bytes, cap);
+	if ((c >= POOL_CLASSES) || (Free[c].size() >= POOL_CLASS_DEPTH) ||
+		(Stats.RetainedBytes + cap > Limit().load(memory_order_relaxed)))
+	{
+		DeleteBuffer(p);
+		return;
+	}
+	try
+	{
+		Free[c].push_back(p);
+	}
+	catch (...)
+	{
+		DeleteBuffer(p);
+		return;
+	}
+	Stats.RetainedBuffers++;
+	Stats.RetainedBytes += cap;
+} /*-------------------------------------------------------------------------*/
+
+inline void TBufferPool::Trim(size_t keep)
+{
+	for (int c = POOL_CLASSES - 1; (c >= 0) && (Stats.RetainedBytes > keep); c--)
+	{
+		size_t cap = CapOf(c);
+		while (!Free[c].empty() && (Stats.RetainedBytes > keep))
+		{
+			DeleteBuffer(Free[c].back());
+			Free[c].pop_back();
+			Stats.RetainedBuffers--;
+			Stats.RetainedBytes -= cap;
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+  // Буферы из пула
+
+// Неинициализированный буфер из bytes байт, выровненный по align
+inline void* PoolAlloc(size_t bytes, size_t align)
+{
+	if (align > POOL_ALIGNMENT)
+		return ::operator new(bytes, align_val_t(align));
+	TBufferPool *pool = TBufferPool::Local();
+	if (pool == nullptr) // полный размер класса: буфер может попасть в пул другого потока
+	{
+		size_t cap;
+		TBufferPool::ClassOf(bytes, cap);
+		return ::operator new(cap, align_val_t(POOL_ALIGNMENT));
+	}
+	return pool->Get(bytes);
+} /*-------------------------------------------------------------------------*/
+
+inline void PoolFree(void *p, size_t bytes, size_t align)
+{
+	TBufferPool *pool = TBufferPool::Local();
+	if ((align > POOL_ALIGNMENT) || (pool == nullptr))
+		::operator delete(p, align_val_t(max(align, POOL_ALIGNMENT)));
+	else
+		pool->Put(p, bytes);
+} /*-------------------------------------------------------------------------*/
+
+  // Управление пулом
+
+// Статистика пула вызывающего потока
+inline TBufferPoolStats GetBufferPoolStats()
+{
+	TBufferPool *pool = TBufferPool::Local();
+	return pool ? pool->GetStats() : TBufferPoolStats();
+} /*-------------------------------------------------------------------------*/
+
+inline void ResetBufferPoolStats()
+{
+	if (TBufferPool *pool = TBufferPool::Local())
+		pool->ResetStats();
+} /*-------------------------------------------------------------------------*/
+
+// Освободить буферы пула вызывающего потока сверх keep байт
+inline void TrimBufferPool(size_t keep = 0)
+{
+	if (TBufferPool *pool = TBufferPool::Local())
+		pool->Trim(keep);
+} /*-------------------------------------------------------------------------*/
+
+// Наибольший объем пула одного потока; 0 - пул отключен
+inline size_t GetBufferPoolLimit()
+{
+	return TBufferPool::Limit().load();
+} /*-------------------------------------------------------------------------*/
+
+inline void SetBufferPoolLimit(size_t bytes)
+{
+	TBufferPool::Limit().store(bytes);
+	TrimBufferPool(bytes);
+} /*-------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,229 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utreduce.h
+//
+// Свертки векторов и матриц: сумма, нормы, след, максимум модуля.
+// Результат не зависит от числа потоков (побитово): данные делятся на блоки
+// фиксированной длины REDUCE_BLOCK, блок сворачивается в REDUCE_LANES
+// независимых накопителей (компилятор разворачивает их в векторные
+// регистры), накопители и итоги блоков складываются попарным деревом,
+// форма которого определяется только длиной данных. Потоки лишь вычисляют
+// итоги разных блоков. Суммы по строкам и столбцам матрицы вычисляются
+// каждая в одном потоке в фиксированном порядке.
+
+#ifndef __UTREDUCE_H__
+#define __UTREDUCE_H__
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "utmatrix.h"
+
+using namespace std;
+
+const int REDUCE_BLOCK = 4096; // элементов в блоке свертки
+const int REDUCE_RANGE = 256;  // строк или столбцов в части задания
+
+// Число накопителей внутри блока: строка кэша из элементов T
+template <class T>
+struct TReduceLanes
+{
+	static constexpr int value = (sizeof(T) >= 64) ? 1 : (sizeof(T) > 32) ? 2 :
+		(sizeof(T) > 16) ? 4 : int(64 / sizeof(T));
+};
+
+struct TOpMax { template <class A> static A Apply(const A &a, const A &b) { return (a < b) ? b : a; } };
+
+// Отображения элементов перед сверткой
+struct TMapId { template <class T> static T Apply(const T &x) { return x; } };
+struct TMapAbs { template <class T> static T Apply(const T &x) { return (x < T(0)) ? T(0) - x : x; } };
+struct TMapSqr { template <class T> static T Apply(const T &x) { return x * x; } };
+
+// Свертка p[0..n) попарным деревом: на каждом уровне соседние пары
+// складываются, непарный последний элемент переходит на следующий уровень
+template <class T, class Op>
+T ReduceTree(T *p, int n)
+{
+	if (n == 0)
+		return T(0);
+	while (n > 1)
+	{
+		for (int i = 0; i < n / 2; i++)
+			p[i] = Op::Apply(p[2 * i], p[2 * i + 1]);
+		if (n % 2 != 0)
+			p[n / 2] = p[n - 1];
+		n = (n + 1) / 2;
+	}
+	return p[0];
+} /*-------------------------------------------------------------------------*/
+
+// Элемент k источника свертки: массива или операнда выражения
+template <class T>
+const T& ReduceElem(const T *x, int k)
+{
+	return x[k];
+} /*-------------------------------------------------------------------------*/
+
+template <class E>
+typename TExprTraits<E>::Elem ReduceElem(const E &e, int k)
+{
+	return TExprTraits<E>::Get(e, k);
+} /*-------------------------------------------------------------------------*/
+
+// Свертка элементов [k0, k0 + n) источника x: элемент k0 + i попадает
+// в накопитель i % L
+template <class T, class Op, class Map, class X>
+T ReduceBlock(const X &x, int k0, int n)
+{
+	const int L = TReduceLanes<T>::value;
+	T acc[L];
+	for (int l = 0; l < L; l++)
+		acc[l] = T(0);
+	int i = 0;
+	for (; i + L <= n; i += L)
+		for (int l = 0; l < L; l++)
+			acc[l] = Op::Apply(acc[l], Map::Apply(T(ReduceElem(x, k0 + i + l))));
+	for (int l = 0; i < n; i++, l++)
+		acc[l] = Op::Apply(acc[l], Map::Apply(T(ReduceElem(x, k0 + i))));
+	return ReduceTree<T, Op>(acc, L);
+} /*-------------------------------------------------------------------------*/
+
+// Свертка элементов [0, n) источника x (массив или операнд выражения):
+// итоги блоков вычисляются потоками пула, затем складываются деревом;
+// Op - TOpAdd или TOpMax
+template <class T, class Op, class Map, class X>
+T ReduceRange(const X &x, int n)
+{
+	int blocks = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+	if (blocks <= 1)
+		return ReduceBlock<T, Op, Map>(x, 0, n);
+	unique_ptr<T[]> part(new T[blocks]);
+	int tasks = min(blocks, GetNumThreads()), chunk = (blocks + tasks - 1) / tasks;
+	ParallelTasks(tasks, n, [&](int t)
+	{
+		for (int b = t * chunk; b < min(blocks, (t + 1) * chunk); b++)
+			part[b] = ReduceBlock<T, Op, Map>(x, b * REDUCE_BLOCK,
+				min(REDUCE_BLOCK, n - b * REDUCE_BLOCK));
+	});
+	return ReduceTree<T, Op>(part.get(), blocks);
+} /*-------------------------------------------------------------------------*/
+
+// Свертка вектора или векторного выражения; элементы, лежащие подряд,
+// читаются по указателю
+template <class Op, class Map, class V>
+typename TExprTraits<V>::Elem ReduceVector(const V &v)
+{
+	typedef typename TExprTraits<V>::Elem Elem;
+	if constexpr (IsDenseOperand<V>::value)
+		return ReduceRange<Elem, Op, Map>(TExprTraits<V>::Data(v), TExprTraits<V>::Length(v));
+	else
+		return ReduceRange<Elem, Op, Map>(v, TExprTraits<V>::Length(v));
+} /*-------------------------------------------------------------------------*/
+
+  // Свертки вектора: V - TVector, представление вектора (utview.h) или
+  // векторное выражение (a + b и т.п. - без вычисления во временный вектор)
+
+template <class V> // сумма элементов
+typename enable_if<TExprTraits<V>::Kind == 1, typename TExprTraits<V>::Elem>::type
+Sum(const V &v)
+{
+	return ReduceVector<TOpAdd, TMapId>(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class V> // сумма модулей
+typename enable_if<TExprTraits<V>::Kind == 1, typename TExprTraits<V>::Elem>::type
+Norm1(const V &v)
+{
+	return ReduceVector<TOpAdd, TMapAbs>(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class V> // евклидова норма
+auto Norm2(const V &v) -> typename enable_if<TExprTraits<V>::Kind == 1,
+	decltype(sqrt(typename TExprTraits<V>::Elem()))>::type
+{
+	return sqrt(ReduceVector<TOpAdd, TMapSqr>(v));
+} /*-------------------------------------------------------------------------*/
+
+template <class V> // максимум модуля
+typename enable_if<TExprTraits<V>::Kind == 1, typename TExprTraits<V>::Elem>::type
+MaxAbs(const V &v)
+{
+	return ReduceVector<TOpMax, TMapAbs>(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class V> // норма-максимум вектора - максимум модуля
+typename enable_if<TExprTraits<V>::Kind == 1, typename TExprTraits<V>::Elem>::type
+NormInf(const V &v)
+{
+	return MaxAbs(v);
+} /*-------------------------------------------------------------------------*/
+
+  // Свертки матрицы (по хранимому верхнему треугольнику)
+
+template <class ValType> // сумма элементов
+ValType Sum(const TMatrix<ValType> &mt)
+{
+	return ReduceRange<ValType, TOpAdd, TMapId>(mt.GetData(), mt.GetPackedSize());
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // максимум модуля
+ValType MaxAbs(const TMatrix<ValType> &mt)
+{
+	return ReduceRange<ValType, TOpMax, TMapAbs>(mt.GetData(), mt.GetPackedSize());
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // норма Фробениуса
+auto NormFrobenius(const TMatrix<ValType> &mt) -> decltype(sqrt(ValType()))
+{
+	return sqrt(ReduceRange<ValType, TOpAdd, TMapSqr>(mt.GetData(), mt.GetPackedSize()));
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // след
+ValType Trace(const TMatrix<ValType> &mt)
+{
+	int n = mt.GetSize();
+	unique_ptr<ValType[]> d(new ValType[max(n, 1)]);
+	for (int i = 0; i < n; i++)
+		d[i] = mt.GetData()[mt.GetRowOffset(i)];
+	return ReduceRange<ValType, TOpAdd, TMapId>(d.get(), n);
+} /*-------------------------------------------------------------------------*/
+
+// Норма-максимум: наибольшая сумма модулей строки; строки хранятся подряд
+// и сворачиваются каждая как отдельный вектор
+template <class ValType>
+ValType NormInf(const TMatrix<ValType> &mt)
+{
+	int n = mt.GetSize();
+	unique_ptr<ValType[]> rows(new ValType[max(n, 1)]);
+	ParallelTasks((n + REDUCE_RANGE - 1) / REDUCE_RANGE, mt.GetPackedSize(), [&](int t)
+	{
+		for (int i = t * REDUCE_RANGE; i < min(n, (t + 1) * REDUCE_RANGE); i++)
+			rows[i] = ReduceRange<ValType, TOpAdd, TMapAbs>(mt.GetData() + mt.GetRowOffset(i), n - i);
+	});
+	return ReduceBlock<ValType, TOpMax, TMapId>(rows.get(), 0, n);
+} /*-------------------------------------------------------------------------*/
+
+// Норма-1: наибольшая сумма модулей столбца. Столбцы не хранятся подряд,
+// поэтому суммы части столбцов [j0, j1) накапливаются проходом по строкам
+// 0..j1-1 (внутренний цикл по j - подряд в памяти); порядок сложения
+// в каждом столбце - по возрастанию i независимо от числа потоков
+template <class ValType>
+ValType Norm1(const TMatrix<ValType> &mt)
+{
+	int n = mt.GetSize();
+	unique_ptr<ValType[]> cols(new ValType[max(n, 1)]);
+	fill_n(cols.get(), n, ValType(0));
+	ParallelTasks((n + REDUCE_RANGE - 1) / REDUCE_RANGE, mt.GetPackedSize(), [&](int t)
+	{
+		int j0 = t * REDUCE_RANGE, j1 = min(n, j0 + REDUCE_RANGE);
+		for (int i = 0; i < j1; i++)
+		{
+			const ValType *row = mt.GetData() + mt.GetRowOffset(i) - i; // row[j] = mt[i][j]
+			for (int j = max(i, j0); j < j1; j++)
+				cols[j] = cols[j] + TMapAbs::Apply(row[j]);
+		}
+	});
+	return ReduceBlock<ValType, TOpMax, TMapId>(cols.get(), 0, n);
+} /*-------------------------------------------------------------------------*/
+
+#endif
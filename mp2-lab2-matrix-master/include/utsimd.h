@@ -0,0 +1,476 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utsimd.h
+//
+// Векторные ядра (SSE2/AVX2+FMA/AVX-512) для поэлементных операций, скалярного
+// произведения и микроядра блочного умножения над float, double, int32_t и
+// int64_t. Набор инструкций выбирается при первом обращении по cpuid; для
+// остальных типов и на других архитектурах используются скалярные циклы.
+
+#ifndef __UTSIMD_H__
+#define __UTSIMD_H__
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define UT_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(UT_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define UT_TARGET_SSE2   __attribute__((target("sse2")))
+#define UT_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define UT_TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+#else
+#define UT_TARGET_SSE2
+#define UT_TARGET_AVX2
+#define UT_TARGET_AVX512
+#endif
+
+using namespace std;
+
+// Уровни набора инструкций
+enum TSimdLevel { SIMD_SCALAR = 0, SIMD_SSE2 = 1, SIMD_AVX2 = 2, SIMD_AVX512 = 3 }; // AVX2 - с FMA
+
+// Типы, для которых есть векторные ядра
+template <class T> struct TSimdSupported : false_type {};
+template <> struct TSimdSupported<float> : true_type {};
+template <> struct TSimdSupported<double> : true_type {};
+template <> struct TSimdSupported<int32_t> : true_type {};
+template <> struct TSimdSupported<int64_t> : true_type {};
+
+// Определение уровня, поддерживаемого процессором и ОС
+inline TSimdLevel DetectSimdLevel()
+{
+#ifdef UT_SIMD_X86
+	unsigned r[4] = { 0, 0, 0, 0 };
+#ifdef _MSC_VER
+	__cpuidex(reinterpret_cast<int*>(r), 0, 0);
+#else
+	__cpuid_count(0, 0, r[0], r[1], r[2], r[3]);
+#endif
+	unsigned maxLeaf = r[0];
+#ifdef _MSC_VER
+	__cpuidex(reinterpret_cast<int*>(r), 1, 0);
+#else
+	__cpuid_count(1, 0, r[0], r[1], r[2], r[3]);
+#endif
+	if (!(r[3] & (1u << 26)))                          // SSE2
+		return SIMD_SCALAR;
+	if (!(r[2] & (1u << 27)) || !(r[2] & (1u << 28)))  // OSXSAVE, AVX
+		return SIMD_SSE2;
+	bool fma = (r[2] & (1u << 12)) != 0;               // FMA
+#ifdef _MSC_VER
+	unsigned long long xcr0 = _xgetbv(0);
+#else
+	unsigned lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	unsigned long long xcr0 = (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+	if (((xcr0 & 0x6) != 0x6) || (maxLeaf < 7))       // ОС сохраняет YMM
+		return SIMD_SSE2;
+#ifdef _MSC_VER
+	__cpuidex(reinterpret_cast<int*>(r), 7, 0);
+#else
+	__cpuid_count(7, 0, r[0], r[1], r[2], r[3]);
+#endif
+	if (!(r[1] & (1u << 5)) || !fma)                   // AVX2
+		return SIMD_SSE2;
+	if ((r[1] & (1u << 16)) && (r[1] & (1u << 17)) &&  // AVX-512F, AVX-512DQ
+		((xcr0 & 0xE6) == 0xE6))                       // ОС сохраняет ZMM
+		return SIMD_AVX512;
+	return SIMD_AVX2;
+#else
+	return SIMD_SCALAR;
+#endif
+} /*-------------------------------------------------------------------------*/
+
+// Уровень читается каждым вызовом ядра из любого потока, поэтому он атомарный
+inline atomic<TSimdLevel>& SimdLevelRef()
+{
+	static atomic<TSimdLevel> level(DetectSimdLevel());
+	return level;
+} /*-------------------------------------------------------------------------*/
+
+// Текущий уровень
+inline TSimdLevel GetSimdLevel()
+{
+	return SimdLevelRef().load(memory_order_relaxed);
+} /*-------------------------------------------------------------------------*/
+
+// Понизить (или вернуть) уровень; выше поддерживаемого процессором не ставится.
+// Вызов безопасен при работающих потоках: операции, уже выбравшие ядро,
+// завершаются на прежнем уровне
+inline TSimdLevel SetSimdLevel(TSimdLevel level)
+{
+	TSimdLevel best = DetectSimdLevel();
+	level = (level > best) ? best : level;
+	SimdLevelRef().store(level, memory_order_relaxed);
+	return level;
+} /*-------------------------------------------------------------------------*/
+
+// Таблица ядер для типа T
+template <class T>
+struct TSimdKernels
+{
+	void (*Add)(T *d, const T *a, const T *b, int n);     // d = a + b
+	void (*Sub)(T *d, const T *a, const T *b, int n);     // d = a - b
+	void (*AddScalar)(T *d, const T *a, T v, int n);      // d = a + v
+	void (*SubScalar)(T *d, const T *a, T v, int n);      // d = a - v
+	void (*MulScalar)(T *d, const T *a, T v, int n);      // d = a * v
+	T    (*Dot)(const T *a, const T *b, int n);           // (a, b)
+	void (*Axpy)(T *y, T v, const T *x, int n);           // y = y + v * x
+	int MR, NR;                                           // блок микроядра умножения
+	void (*MulMicro)(const T *ap, const T *bp, int k, T *acc); // acc = ap * bp (см. ScalarMulMicro)
+};
+
+const int SIMD_MICRO_MAX = 12 * 32; // элементов в блоке микроядра MR x NR не более
+
+enum { SIMD_OP_ADD, SIMD_OP_SUB, SIMD_OP_MUL };
+
+  // Скалярные ядра
+
+template <class T, int Op>
+void ScalarBinary(T *d, const T *a, const T *b, int n)
+{
+	for (int i = 0; i < n; i++)
+		d[i] = (Op == SIMD_OP_ADD) ? a[i] + b[i] : a[i] - b[i];
+} /*-------------------------------------------------------------------------*/
+
+template <class T, int Op>
+void ScalarWithScalar(T *d, const T *a, T v, int n)
+{
+	for (int i = 0; i < n; i++)
+		d[i] = (Op == SIMD_OP_ADD) ? a[i] + v : (Op == SIMD_OP_SUB) ? a[i] - v : a[i] * v;
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+T ScalarDot(const T *a, const T *b, int n)
+{
+	T s = 0;
+	for (int i = 0; i < n; i++)
+		s = s + a[i] * b[i];
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void ScalarAxpy(T *y, T v, const T *x, int n)
+{
+	for (int i = 0; i < n; i++)
+		y[i] = y[i] + v * x[i];
+} /*-------------------------------------------------------------------------*/
+
+// Микроядро умножения: блок acc (MR x NR по строкам) = сумма по p из [0, k)
+// столбцов ap[p * MR + i] микропанели a на строки bp[p * NR + j] микропанели b
+template <class T, int MR, int NR>
+void ScalarMulMicro(const T *ap, const T *bp, int k, T *acc)
+{
+	for (int i = 0; i < MR * NR; i++)
+		acc[i] = T(0);
+	for (int p = 0; p < k; p++)
+		for (int i = 0; i < MR; i++)
+		{
+			T a = ap[p * MR + i];
+			for (int j = 0; j < NR; j++)
+				acc[i * NR + j] = acc[i * NR + j] + a * bp[p * NR + j];
+		}
+} /*-------------------------------------------------------------------------*/
+
+// Блок скалярного микроядра (без векторных регистров)
+template <class T>
+struct TScalarMicro
+{
+	static const int MR = 4;
+	static const int NR = (sizeof(T) >= 8) ? 8 : 16;
+};
+
+#ifdef UT_SIMD_X86
+
+  // Операции над регистрами: V::Reg - регистр, V::W - число элементов в нем,
+  // V::HasMul - есть ли поэлементное умножение на данном уровне (если нет,
+  // Mul и MulAdd - заглушки и не вызываются); MulAdd(x, y, z) = x * y + z
+  // (FMA для float и double на уровнях AVX2 и AVX-512)
+
+#define UT_SIMD_REG_OPS(Name, Target, TT, R, WW, MUL, LD, ST, SET1, ZERO, ADD, SUB, MULOP, MULADD) \
+struct Name                                                                     \
+{                                                                               \
+	typedef TT T;                                                               \
+	typedef R Reg;                                                              \
+	static const int W = WW;                                                    \
+	static const bool HasMul = MUL;                                             \
+	Target static Reg Load(const T *p) { return LD; }                           \
+	Target static void Store(T *p, Reg x) { ST; }                               \
+	Target static Reg Set1(T v) { return SET1; }                                \
+	Target static Reg Zero() { return ZERO; }                                   \
+	Target static Reg Add(Reg x, Reg y) { return ADD; }                         \
+	Target static Reg Sub(Reg x, Reg y) { return SUB; }                         \
+	Target static Reg Mul(Reg x, [[maybe_unused]] Reg y) { return MULOP; }      \
+	Target static Reg MulAdd([[maybe_unused]] Reg x, [[maybe_unused]] Reg y, Reg z) \
+		{ return MULADD; }                                                      \
+	Target static T Sum(Reg x)                                                  \
+	{                                                                           \
+		alignas(64) T t[W];                                                     \
+		Store(t, x);                                                            \
+		T s = 0;                                                                \
+		for (int i = 0; i < W; i++)                                             \
+			s = s + t[i];                                                       \
+		return s;                                                               \
+	}                                                                           \
+};
+
+UT_SIMD_REG_OPS(TSse2Float, UT_TARGET_SSE2, float, __m128, 4, true,
+	_mm_loadu_ps(p), _mm_storeu_ps(p, x), _mm_set1_ps(v), _mm_setzero_ps(),
+	_mm_add_ps(x, y), _mm_sub_ps(x, y), _mm_mul_ps(x, y), _mm_add_ps(_mm_mul_ps(x, y), z))
+UT_SIMD_REG_OPS(TSse2Double, UT_TARGET_SSE2, double, __m128d, 2, true,
+	_mm_loadu_pd(p), _mm_storeu_pd(p, x), _mm_set1_pd(v), _mm_setzero_pd(),
+	_mm_add_pd(x, y), _mm_sub_pd(x, y), _mm_mul_pd(x, y), _mm_add_pd(_mm_mul_pd(x, y), z))
+UT_SIMD_REG_OPS(TSse2Int32, UT_TARGET_SSE2, int32_t, __m128i, 4, false,
+	_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), x), _mm_set1_epi32(v),
+	_mm_setzero_si128(), _mm_add_epi32(x, y), _mm_sub_epi32(x, y), x, z)
+UT_SIMD_REG_OPS(TSse2Int64, UT_TARGET_SSE2, int64_t, __m128i, 2, false,
+	_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), x), _mm_set1_epi64x(v),
+	_mm_setzero_si128(), _mm_add_epi64(x, y), _mm_sub_epi64(x, y), x, z)
+
+UT_SIMD_REG_OPS(TAvx2Float, UT_TARGET_AVX2, float, __m256, 8, true,
+	_mm256_loadu_ps(p), _mm256_storeu_ps(p, x), _mm256_set1_ps(v), _mm256_setzero_ps(),
+	_mm256_add_ps(x, y), _mm256_sub_ps(x, y), _mm256_mul_ps(x, y), _mm256_fmadd_ps(x, y, z))
+UT_SIMD_REG_OPS(TAvx2Double, UT_TARGET_AVX2, double, __m256d, 4, true,
+	_mm256_loadu_pd(p), _mm256_storeu_pd(p, x), _mm256_set1_pd(v), _mm256_setzero_pd(),
+	_mm256_add_pd(x, y), _mm256_sub_pd(x, y), _mm256_mul_pd(x, y), _mm256_fmadd_pd(x, y, z))
+UT_SIMD_REG_OPS(TAvx2Int32, UT_TARGET_AVX2, int32_t, __m256i, 8, true,
+	_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x), _mm256_set1_epi32(v),
+	_mm256_setzero_si256(), _mm256_add_epi32(x, y), _mm256_sub_epi32(x, y),
+	_mm256_mullo_epi32(x, y), _mm256_add_epi32(_mm256_mullo_epi32(x, y), z))
+UT_SIMD_REG_OPS(TAvx2Int64, UT_TARGET_AVX2, int64_t, __m256i, 4, false,
+	_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x), _mm256_set1_epi64x(v),
+	_mm256_setzero_si256(), _mm256_add_epi64(x, y), _mm256_sub_epi64(x, y), x, z)
+
+UT_SIMD_REG_OPS(TAvx512Float, UT_TARGET_AVX512, float, __m512, 16, true,
+	_mm512_loadu_ps(p), _mm512_storeu_ps(p, x), _mm512_set1_ps(v), _mm512_setzero_ps(),
+	_mm512_add_ps(x, y), _mm512_sub_ps(x, y), _mm512_mul_ps(x, y), _mm512_fmadd_ps(x, y, z))
+UT_SIMD_REG_OPS(TAvx512Double, UT_TARGET_AVX512, double, __m512d, 8, true,
+	_mm512_loadu_pd(p), _mm512_storeu_pd(p, x), _mm512_set1_pd(v), _mm512_setzero_pd(),
+	_mm512_add_pd(x, y), _mm512_sub_pd(x, y), _mm512_mul_pd(x, y), _mm512_fmadd_pd(x, y, z))
+UT_SIMD_REG_OPS(TAvx512Int32, UT_TARGET_AVX512, int32_t, __m512i, 16, true,
+	_mm512_loadu_si512(p), _mm512_storeu_si512(p, x), _mm512_set1_epi32(v),
+	_mm512_setzero_si512(), _mm512_add_epi32(x, y), _mm512_sub_epi32(x, y),
+	_mm512_mullo_epi32(x, y), _mm512_add_epi32(_mm512_mullo_epi32(x, y), z))
+UT_SIMD_REG_OPS(TAvx512Int64, UT_TARGET_AVX512, int64_t, __m512i, 8, true,
+	_mm512_loadu_si512(p), _mm512_storeu_si512(p, x), _mm512_set1_epi64(v),
+	_mm512_setzero_si512(), _mm512_add_epi64(x, y), _mm512_sub_epi64(x, y),
+	_mm512_mullo_epi64(x, y), _mm512_add_epi64(_mm512_mullo_epi64(x, y), z))
+
+#undef UT_SIMD_REG_OPS
+
+  // Ядра одного уровня; скалярное произведение ведется в четырех независимых
+  // аккумуляторах, чтобы не ждать задержку сложения на каждой итерации.
+  // Микроядро умножения держит блок MR x 2W в 2 * MR регистрах: на каждом
+  // шаге p загружаются две строки микропанели b, элемент микропанели a
+  // размножается по регистру и накапливается умножением-сложением (FMA)
+
+#define UT_SIMD_KERNELS(Prefix, Target)                                         \
+template <class V, int Op>                                                      \
+Target void Prefix##Binary(typename V::T *d, const typename V::T *a,            \
+	const typename V::T *b, int n)                                              \
+{                                                                               \
+	int i = 0;                                                                  \
+	for (; i + 2 * V::W <= n; i += 2 * V::W)                                    \
+	{                                                                           \
+		typename V::Reg x0 = V::Load(a + i), x1 = V::Load(a + i + V::W);        \
+		typename V::Reg y0 = V::Load(b + i), y1 = V::Load(b + i + V::W);        \
+		V::Store(d + i, (Op == SIMD_OP_ADD) ? V::Add(x0, y0) : V::Sub(x0, y0)); \
+		V::Store(d + i + V::W, (Op == SIMD_OP_ADD) ? V::Add(x1, y1) : V::Sub(x1, y1)); \
+	}                                                                           \
+	for (; i + V::W <= n; i += V::W)                                            \
+	{                                                                           \
+		typename V::Reg x = V::Load(a + i), y = V::Load(b + i);                 \
+		V::Store(d + i, (Op == SIMD_OP_ADD) ? V::Add(x, y) : V::Sub(x, y));     \
+	}                                                                           \
+	ScalarBinary<typename V::T, Op>(d + i, a + i, b + i, n - i);                \
+}                                                                               \
+                                                                                \
+template <class V, int Op>                                                      \
+Target void Prefix##WithScalar(typename V::T *d, const typename V::T *a,        \
+	typename V::T v, int n)                                                     \
+{                                                                               \
+	int i = 0;                                                                  \
+	if constexpr ((Op != SIMD_OP_MUL) || V::HasMul)                             \
+	{                                                                           \
+		typename V::Reg y = V::Set1(v);                                         \
+		for (; i + V::W <= n; i += V::W)                                        \
+		{                                                                       \
+			typename V::Reg x = V::Load(a + i);                                 \
+			V::Store(d + i, (Op == SIMD_OP_ADD) ? V::Add(x, y) :                \
+				(Op == SIMD_OP_SUB) ? V::Sub(x, y) : V::Mul(x, y));             \
+		}                                                                       \
+	}                                                                           \
+	ScalarWithScalar<typename V::T, Op>(d + i, a + i, v, n - i);                \
+}                                                                               \
+                                                                                \
+template <class V>                                                              \
+Target typename V::T Prefix##Dot(const typename V::T *a, const typename V::T *b, int n) \
+{                                                                               \
+	if constexpr (!V::HasMul)                                                   \
+		return ScalarDot(a, b, n);                                              \
+	else                                                                        \
+	{                                                                           \
+		typename V::Reg s0 = V::Zero(), s1 = V::Zero(), s2 = V::Zero(), s3 = V::Zero(); \
+		int i = 0;                                                              \
+		for (; i + 4 * V::W <= n; i += 4 * V::W)                                \
+		{                                                                       \
+			s0 = V::Add(s0, V::Mul(V::Load(a + i), V::Load(b + i)));            \
+			s1 = V::Add(s1, V::Mul(V::Load(a + i + V::W), V::Load(b + i + V::W))); \
+			s2 = V::Add(s2, V::Mul(V::Load(a + i + 2 * V::W), V::Load(b + i + 2 * V::W))); \
+			s3 = V::Add(s3, V::Mul(V::Load(a + i + 3 * V::W), V::Load(b + i + 3 * V::W))); \
+		}                                                                       \
+		for (; i + V::W <= n; i += V::W)                                        \
+			s0 = V::Add(s0, V::Mul(V::Load(a + i), V::Load(b + i)));            \
+		typename V::T s = V::Sum(V::Add(V::Add(s0, s1), V::Add(s2, s3)));       \
+		return s + ScalarDot(a + i, b + i, n - i);                              \
+	}                                                                           \
+}                                                                               \
+                                                                                \
+template <class V>                                                              \
+Target void Prefix##Axpy(typename V::T *y, typename V::T v, const typename V::T *x, int n) \
+{                                                                               \
+	int i = 0;                                                                  \
+	if constexpr (V::HasMul)                                                    \
+	{                                                                           \
+		typename V::Reg a = V::Set1(v);                                         \
+		for (; i + 2 * V::W <= n; i += 2 * V::W)                                \
+		{                                                                       \
+			typename V::Reg y0 = V::Add(V::Load(y + i), V::Mul(a, V::Load(x + i))); \
+			typename V::Reg y1 = V::Add(V::Load(y + i + V::W), V::Mul(a, V::Load(x + i + V::W))); \
+			V::Store(y + i, y0);                                                \
+			V::Store(y + i + V::W, y1);                                         \
+		}                                                                       \
+		for (; i + V::W <= n; i += V::W)                                        \
+			V::Store(y + i, V::Add(V::Load(y + i), V::Mul(a, V::Load(x + i)))); \
+	}                                                                           \
+	ScalarAxpy(y + i, v, x + i, n - i);                                         \
+}                                                                               \
+                                                                                \
+template <class V, int MR>                                                      \
+Target void Prefix##MulMicro(const typename V::T *ap, const typename V::T *bp,  \
+	int k, typename V::T *acc)                                                  \
+{                                                                               \
+	const int NR = 2 * V::W;                                                    \
+	typename V::Reg c0[MR], c1[MR];                                             \
+	for (int i = 0; i < MR; i++)                                                \
+		c0[i] = c1[i] = V::Zero();                                              \
+	for (int p = 0; p < k; p++, ap += MR, bp += NR)                             \
+	{                                                                           \
+		typename V::Reg b0 = V::Load(bp), b1 = V::Load(bp + V::W);              \
+		for (int i = 0; i < MR; i++)                                            \
+		{                                                                       \
+			typename V::Reg a = V::Set1(ap[i]);                                 \
+			c0[i] = V::MulAdd(a, b0, c0[i]);                                    \
+			c1[i] = V::MulAdd(a, b1, c1[i]);                                    \
+		}                                                                       \
+	}                                                                           \
+	for (int i = 0; i < MR; i++)                                                \
+	{                                                                           \
+		V::Store(acc + i * NR, c0[i]);                                          \
+		V::Store(acc + i * NR + V::W, c1[i]);                                   \
+	}                                                                           \
+}
+
+UT_SIMD_KERNELS(Sse2, UT_TARGET_SSE2)
+UT_SIMD_KERNELS(Avx2, UT_TARGET_AVX2)
+UT_SIMD_KERNELS(Avx512, UT_TARGET_AVX512)
+
+#undef UT_SIMD_KERNELS
+
+// Наборы регистровых операций для типа T
+template <class T> struct TSimdIsa;
+template <> struct TSimdIsa<float>   { typedef TSse2Float Sse2;  typedef TAvx2Float Avx2;  typedef TAvx512Float Avx512; };
+template <> struct TSimdIsa<double>  { typedef TSse2Double Sse2; typedef TAvx2Double Avx2; typedef TAvx512Double Avx512; };
+template <> struct TSimdIsa<int32_t> { typedef TSse2Int32 Sse2;  typedef TAvx2Int32 Avx2;  typedef TAvx512Int32 Avx512; };
+template <> struct TSimdIsa<int64_t> { typedef TSse2Int64 Sse2;  typedef TAvx2Int64 Avx2;  typedef TAvx512Int64 Avx512; };
+
+#endif // UT_SIMD_X86
+
+// Таблица ядер заданного уровня. Блок микроядра умножения подобран под
+// число регистров: 6 x 2W на SSE2 и AVX2 (16 регистров: 12 под блок, 2 под
+// строку b, 1 под элемент a), 12 x 2W на AVX-512 (32 регистра: 24 под блок);
+// без векторного умножения - скалярное микроядро TScalarMicro
+template <class T>
+TSimdKernels<T> MakeSimdKernels(TSimdLevel level)
+{
+	typedef TScalarMicro<T> M;
+	TSimdKernels<T> k = { ScalarBinary<T, SIMD_OP_ADD>, ScalarBinary<T, SIMD_OP_SUB>,
+		ScalarWithScalar<T, SIMD_OP_ADD>, ScalarWithScalar<T, SIMD_OP_SUB>,
+		ScalarWithScalar<T, SIMD_OP_MUL>, ScalarDot<T>, ScalarAxpy<T>,
+		M::MR, M::NR, ScalarMulMicro<T, M::MR, M::NR> };
+#ifdef UT_SIMD_X86
+	typedef typename TSimdIsa<T>::Sse2 S;
+	typedef typename TSimdIsa<T>::Avx2 A;
+	typedef typename TSimdIsa<T>::Avx512 Z;
+	if (level == SIMD_SSE2)
+	{
+		TSimdKernels<T> s = { Sse2Binary<S, SIMD_OP_ADD>, Sse2Binary<S, SIMD_OP_SUB>,
+			Sse2WithScalar<S, SIMD_OP_ADD>, Sse2WithScalar<S, SIMD_OP_SUB>,
+			Sse2WithScalar<S, SIMD_OP_MUL>, Sse2Dot<S>, Sse2Axpy<S>,
+			k.MR, k.NR, k.MulMicro };
+		if constexpr (S::HasMul)
+		{
+			s.MR = 6;
+			s.NR = 2 * S::W;
+			s.MulMicro = Sse2MulMicro<S, 6>;
+		}
+		k = s;
+	}
+	else if (level == SIMD_AVX2)
+	{
+		TSimdKernels<T> a = { Avx2Binary<A, SIMD_OP_ADD>, Avx2Binary<A, SIMD_OP_SUB>,
+			Avx2WithScalar<A, SIMD_OP_ADD>, Avx2WithScalar<A, SIMD_OP_SUB>,
+			Avx2WithScalar<A, SIMD_OP_MUL>, Avx2Dot<A>, Avx2Axpy<A>,
+			k.MR, k.NR, k.MulMicro };
+		if constexpr (A::HasMul)
+		{
+			a.MR = 6;
+			a.NR = 2 * A::W;
+			a.MulMicro = Avx2MulMicro<A, 6>;
+		}
+		k = a;
+	}
+	else if (level == SIMD_AVX512)
+	{
+		TSimdKernels<T> z = { Avx512Binary<Z, SIMD_OP_ADD>, Avx512Binary<Z, SIMD_OP_SUB>,
+			Avx512WithScalar<Z, SIMD_OP_ADD>, Avx512WithScalar<Z, SIMD_OP_SUB>,
+			Avx512WithScalar<Z, SIMD_OP_MUL>, Avx512Dot<Z>, Avx512Axpy<Z>,
+			k.MR, k.NR, k.MulMicro };
+		if constexpr (Z::HasMul)
+		{
+			z.MR = 12;
+			z.NR = 2 * Z::W;
+			z.MulMicro = Avx512MulMicro<Z, 12>;
+		}
+		k = z;
+	}
+#endif
+	return k;
+} /*-------------------------------------------------------------------------*/
+
+// Ядра текущего уровня
+template <class T>
+const TSimdKernels<T>& SimdKernels()
+{
+	static const TSimdKernels<T> table[4] = { MakeSimdKernels<T>(SIMD_SCALAR),
+		MakeSimdKernels<T>(SIMD_SSE2), MakeSimdKernels<T>(SIMD_AVX2),
+		MakeSimdKernels<T>(SIMD_AVX512) };
+	return table[GetSimdLevel()];
+} /*-------------------------------------------------------------------------*/
+
+#endif
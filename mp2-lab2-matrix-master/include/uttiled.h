@@ -0,0 +1,428 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// uttiled.h
+//
+// Плиточный формат верхнетреугольной матрицы. Матрица делится на плитки
+// Tile x Tile: плитки над диагональю хранятся плотными квадратами по
+// строкам, диагональные - упакованными треугольниками (как TMatrix).
+// Каждая плитка занимает непрерывный участок буфера, плитки следуют друг
+// за другом построчно (TILE_ROWS) или в рекурсивном порядке Мортона
+// (TILE_MORTON), при котором соседние по индексам плитки лежат рядом
+// в памяти при любом размере кэша. Умножение, умножение на вектор и
+// решение системы проходят по плиткам, а одна плитка целиком помещается
+// в кэш первого уровня. Последние плитки дополняются до полного размера
+// нулями с единицами на диагонали, поэтому ядра не проверяют границы.
+
+#ifndef __UTTILED_H__
+#define __UTTILED_H__
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "utmatrix.h"
+
+using namespace std;
+
+const int TILE_SIZE = 64; // 64 x 64 элементов double - 32 Кб, кэш L1
+
+enum TTileOrder
+{
+	TILE_ROWS,  // по строкам плиток
+	TILE_MORTON // рекурсивный Z-порядок
+};
+
+// Ключ Z-порядка: чередование битов номеров строки и столбца плитки
+inline unsigned MortonKey(unsigned i, unsigned j)
+{
+	unsigned k = 0;
+	for (int b = 0; b < 16; b++)
+		k |= (((i >> b) & 1u) << (2 * b + 1)) | (((j >> b) & 1u) << (2 * b));
+	return k;
+} /*-------------------------------------------------------------------------*/
+
+// c += a * b для плотных плиток t x t по строкам; upperA/upperB - плитка
+// верхнетреугольная (нули под диагональю не обрабатываются). Строки b и c
+// короткие и остаются в кэше L1, обновление строки - ядро Axpy
+template <class T>
+void TileMulAdd(const T *a, bool upperA, const T *b, bool upperB, T *c, int t)
+{
+	for (int i = 0; i < t; i++)
+		for (int k = upperA ? i : 0; k < t; k++)
+		{
+			int j0 = upperB ? k : 0;
+			AxpyRange(c + i * t + j0, a[i * t + k], b + k * t + j0, t - j0);
+		}
+} /*-------------------------------------------------------------------------*/
+
+// Диагональная плитка из упакованного треугольника в плотный квадрат
+template <class T>
+void UnpackTriTile(const T *p, const int *off, int t, T *d)
+{
+	fill_n(d, t * t, T(0));
+	for (int i = 0; i < t; i++)
+		copy_n(p + off[i], t - i, d + i * t + i);
+} /*-------------------------------------------------------------------------*/
+
+// Шаблон плиточной матрицы
+template <class ValType>
+class TTiledMatrix
+{
+protected:
+	int Size;         // размер матрицы
+	int Tile;         // размер плитки
+	int Blocks;       // число плиток по стороне
+	TTileOrder Order; // порядок плиток в буфере
+	ValType *pElem;   // плитки
+	int ElemCount;    // число элементов в буфере (с дополнением)
+	int *pTile;       // начала плиток (I, J), J >= I, в порядке TileIndex
+	int *pDiag;       // смещения строк внутри диагональной плитки
+
+	void Allocate(int s, int tile, TTileOrder order);
+	void Release();
+	void Swap(TTiledMatrix &mt) noexcept;
+	int TileIndex(int I, int J) const { return I * Blocks - I * (I - 1) / 2 + (J - I); }
+	ValType* TilePtr(int I, int J) { return pElem + pTile[TileIndex(I, J)]; }
+	const ValType* TilePtr(int I, int J) const { return pElem + pTile[TileIndex(I, J)]; }
+	int Index(int i, int j) const;      // позиция элемента (i, j), j >= i, в буфере
+public:
+	TTiledMatrix(int s = 10, int tile = TILE_SIZE, TTileOrder order = TILE_MORTON); // нулевая
+	explicit TTiledMatrix(const TMatrix<ValType> &mt, int tile = TILE_SIZE,
+		TTileOrder order = TILE_MORTON);  // из построчного формата
+	TTiledMatrix(const TTiledMatrix &mt);
+	TTiledMatrix(TTiledMatrix &&mt) noexcept;
+	~TTiledMatrix() { Release(); }
+	int GetSize() const { return Size; }
+	int GetTileSize() const { return Tile; }
+	TTileOrder GetOrder() const { return Order; }
+	ValType* GetData() { return pElem; } // буфер плиток
+	const ValType* GetData() const { return pElem; }
+	int GetStoredSize() const { return ElemCount; }
+	int GetTileOffset(int I, int J) const { return pTile[TileIndex(I, J)]; } // начало плитки
+	ValType& operator()(int i, int j);  // доступ к (i, j), j >= i
+	const ValType& operator()(int i, int j) const;
+	TMatrix<ValType> ToMatrix() const;  // в построчный формат
+	bool operator==(const TTiledMatrix &mt) const;
+	bool operator!=(const TTiledMatrix &mt) const { return !(*this == mt); }
+	TTiledMatrix& operator=(const TTiledMatrix &mt);
+	TTiledMatrix& operator=(TTiledMatrix &&mt) noexcept;
+
+	TTiledMatrix operator*(const TTiledMatrix &mt) const;          // умножение по плиткам
+	TVector<ValType> operator*(const TVector<ValType> &v) const;   // U * v
+	TVector<ValType> MulTransposed(const TVector<ValType> &v) const; // U^T * v
+	TVector<ValType> Solve(const TVector<ValType> &b) const;       // решение Ux = b
+};
+
+template <class ValType>
+void TTiledMatrix<ValType>::Allocate(int s, int tile, TTileOrder order)
+{
+	if ((s > MAX_MATRIX_SIZE) || (s < 0))
+		throw "Negative size";
+	if (tile < 1)
+		throw "Error";
+	int blocks = (s + tile - 1) / tile, tiles = blocks * (blocks + 1) / 2;
+	vector<pair<unsigned, int> > keys; // (ключ порядка, номер плитки)
+	vector<bool> diag;                 // плитка диагональная
+	keys.reserve(tiles);
+	diag.reserve(tiles);
+	for (int I = 0; I < blocks; I++)
+		for (int J = I; J < blocks; J++)
+		{
+			keys.push_back(make_pair((order == TILE_MORTON) ? MortonKey(I, J) :
+				unsigned(I * blocks + J), int(keys.size())));
+			diag.push_back(I == J);
+		}
+	sort(keys.begin(), keys.end());
+	unique_ptr<int[]> ptile(new int[max(tiles, 1)]), pdiag(new int[tile + 1]);
+	Size = s;
+	Tile = tile;
+	Blocks = blocks;
+	Order = order;
+	int count = 0;
+	for (int t = 0; t < tiles; t++)
+	{
+		int k = keys[t].second;
+		ptile[k] = count;
+		count += diag[k] ? tile * (tile + 1) / 2 : tile * tile;
+	}
+	pdiag[0] = 0;
+	for (int i = 0; i < tile; i++)
+		pdiag[i + 1] = pdiag[i] + (tile - i);
+	pElem = AllocAligned<ValType>(count);
+	fill_n(pElem, count, ValType(0)); // нули под диагональю плиток и в дополнении
+	ElemCount = count;
+	pTile = ptile.release();
+	pDiag = pdiag.release();
+	for (int i = Size; i < Blocks * Tile; i++) // дополнение: единичная диагональ
+		pElem[pTile[TileIndex(i / Tile, i / Tile)] + pDiag[i % Tile]] = ValType(1);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void TTiledMatrix<ValType>::Release()
+{
+	FreeAligned(pElem, ElemCount);
+	delete[] pTile;
+	delete[] pDiag;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+void TTiledMatrix<ValType>::Swap(TTiledMatrix<ValType> &mt) noexcept
+{
+	swap(Size, mt.Size);
+	swap(Tile, mt.Tile);
+	swap(Blocks, mt.Blocks);
+	swap(Order, mt.Order);
+	swap(pElem, mt.pElem);
+	swap(ElemCount, mt.ElemCount);
+	swap(pTile, mt.pTile);
+	swap(pDiag, mt.pDiag);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+int TTiledMatrix<ValType>::Index(int i, int j) const
+{
+	int I = i / Tile, J = j / Tile, a = i - I * Tile, b = j - J * Tile;
+	if (I == J)
+		return pTile[TileIndex(I, I)] + pDiag[a] + (b - a);
+	return pTile[TileIndex(I, J)] + a * Tile + b;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TTiledMatrix<ValType>::TTiledMatrix(int s, int tile, TTileOrder order) :
+	pElem(nullptr), ElemCount(0), pTile(nullptr), pDiag(nullptr)
+{
+	Allocate(s, tile, order);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // из построчного формата: строка i раскладывается
+TTiledMatrix<ValType>::TTiledMatrix(const TMatrix<ValType> &mt, int tile, // по плиткам
+	TTileOrder order) : pElem(nullptr), ElemCount(0), pTile(nullptr), pDiag(nullptr)
+{
+	Allocate(mt.GetSize(), tile, order);
+	for (int i = 0; i < Size; i++)
+	{
+		const ValType *row = mt.GetData() + mt.GetRowOffset(i) - i; // row[j] = mt[i][j]
+		for (int j = i; j < Size; j = (j / Tile + 1) * Tile)
+			copy(row + j, row + min(Size, (j / Tile + 1) * Tile), pElem + Index(i, j));
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // конструктор копирования
+TTiledMatrix<ValType>::TTiledMatrix(const TTiledMatrix<ValType> &mt) :
+	pElem(nullptr), ElemCount(0), pTile(nullptr), pDiag(nullptr)
+{
+	Allocate(mt.Size, mt.Tile, mt.Order);
+	copy_n(mt.pElem, ElemCount, pElem);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещение
+TTiledMatrix<ValType>::TTiledMatrix(TTiledMatrix<ValType> &&mt) noexcept :
+	Size(0), Tile(TILE_SIZE), Blocks(0), Order(TILE_MORTON), pElem(nullptr),
+	ElemCount(0), pTile(nullptr), pDiag(nullptr)
+{
+	Swap(mt);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ
+ValType& TTiledMatrix<ValType>::operator()(int i, int j)
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((i < 0) || (j < i) || (j >= Size))
+		throw "Index out of range";
+#endif
+	return pElem[Index(i, j)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ к константной матрице
+const ValType& TTiledMatrix<ValType>::operator()(int i, int j) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((i < 0) || (j < i) || (j >= Size))
+		throw "Index out of range";
+#endif
+	return pElem[Index(i, j)];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // в построчный формат
+TMatrix<ValType> TTiledMatrix<ValType>::ToMatrix() const
+{
+	TMatrix<ValType> mt(Size);
+	for (int i = 0; i < Size; i++)
+	{
+		ValType *row = mt.GetData() + mt.GetRowOffset(i) - i;
+		for (int j = i; j < Size; j = (j / Tile + 1) * Tile)
+		{
+			const ValType *p = pElem + Index(i, j);
+			copy(p, p + (min(Size, (j / Tile + 1) * Tile) - j), row + j);
+		}
+	}
+	return mt;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // сравнение (размер плиток и порядок не учитываются)
+bool TTiledMatrix<ValType>::operator==(const TTiledMatrix<ValType> &mt) const
+{
+	if (Size != mt.Size)
+		return false;
+	if ((Tile == mt.Tile) && (Order == mt.Order))
+		return equal(pElem, pElem + ElemCount, mt.pElem);
+	for (int i = 0; i < Size; i++)
+		for (int j = i; j < Size; j++)
+			if (!(pElem[Index(i, j)] == mt.pElem[mt.Index(i, j)]))
+				return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // присваивание
+TTiledMatrix<ValType>& TTiledMatrix<ValType>::operator=(const TTiledMatrix<ValType> &mt)
+{
+	if (this != &mt)
+	{
+		TTiledMatrix<ValType> tmp(mt);
+		Swap(tmp);
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // перемещающее присваивание
+TTiledMatrix<ValType>& TTiledMatrix<ValType>::operator=(TTiledMatrix<ValType> &&mt) noexcept
+{
+	Swap(mt);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+// Умножение: плитка результата (I, J) = сумма A(I, K) * B(K, J) по K из
+// [I, J] накапливается в плотном буфере в кэше и записывается один раз.
+// Плитки результата независимы и распределяются между потоками пула
+template <class ValType>
+TTiledMatrix<ValType> TTiledMatrix<ValType>::operator*(const TTiledMatrix<ValType> &mt) const
+{
+	if (Size != mt.Size)
+		throw "Error";
+	if (mt.Tile != Tile)
+		return *this * TTiledMatrix<ValType>(mt.ToMatrix(), Tile, Order);
+	TTiledMatrix<ValType> c(Size, Tile, Order);
+	const int t = Tile;
+	vector<pair<int, int> > tiles; // плитки результата в порядке буфера
+	for (int I = 0; I < Blocks; I++)
+		for (int J = I; J < Blocks; J++)
+			tiles.push_back(make_pair(I, J));
+	sort(tiles.begin(), tiles.end(), [&](const pair<int, int> &x, const pair<int, int> &y)
+		{ return c.GetTileOffset(x.first, x.second) < c.GetTileOffset(y.first, y.second); });
+	ParallelTasks(int(tiles.size()), c.ElemCount, [&](int n)
+	{
+		int I = tiles[n].first, J = tiles[n].second;
+		unique_ptr<ValType[]> buf(new ValType[3 * t * t]);
+		ValType *acc = buf.get(), *da = acc + t * t, *db = da + t * t;
+		fill_n(acc, t * t, ValType(0));
+		for (int K = I; K <= J; K++)
+		{
+			const ValType *a = TilePtr(I, K), *b = mt.TilePtr(K, J);
+			if (K == I)
+			{
+				UnpackTriTile(a, pDiag, t, da);
+				a = da;
+			}
+			if (K == J)
+			{
+				UnpackTriTile(b, pDiag, t, db);
+				b = db;
+			}
+			TileMulAdd(a, K == I, b, K == J, acc, t);
+		}
+		ValType *p = c.TilePtr(I, J);
+		if (I == J)
+			for (int i = 0; i < t; i++)
+				copy_n(acc + i * t + i, t - i, p + pDiag[i]);
+		else
+			copy_n(acc, t * t, p);
+	});
+	return c;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение на вектор
+TVector<ValType> TTiledMatrix<ValType>::operator*(const TVector<ValType> &v) const
+{
+	if (Size != v.GetSize())
+		throw "Error";
+	ValType (*dot)(const ValType*, const ValType*, int) = ScalarDot<ValType>;
+	if constexpr (TSimdSupported<ValType>::value)
+		dot = SimdKernels<ValType>().Dot;
+	const int t = Tile, n = Blocks * Tile;
+	unique_ptr<ValType[]> buf(new ValType[2 * n]());
+	ValType *x = buf.get(), *y = x + n;
+	copy_n(v.GetData(), Size, x);
+	for (int I = 0; I < Blocks; I++)
+	{
+		ValType *yi = y + I * t;
+		TriMatVecPacked(TilePtr(I, I), pDiag, t, x + I * t, yi);
+		for (int J = I + 1; J < Blocks; J++)
+		{
+			const ValType *p = TilePtr(I, J);
+			for (int a = 0; a < t; a++)
+				yi[a] = yi[a] + dot(p + a * t, x + J * t, t);
+		}
+	}
+	TVector<ValType> r(Size);
+	copy_n(y, Size, r.GetData());
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение транспонированной матрицы на вектор:
+TVector<ValType> TTiledMatrix<ValType>::MulTransposed(const TVector<ValType> &v) const
+{                        // строки плиток читаются подряд (см. TriMatTVecPacked)
+	if (Size != v.GetSize())
+		throw "Error";
+	const int t = Tile, n = Blocks * Tile;
+	unique_ptr<ValType[]> buf(new ValType[2 * n]());
+	ValType *x = buf.get(), *y = x + n;
+	copy_n(v.GetData(), Size, x);
+	for (int I = 0; I < Blocks; I++)
+	{
+		TriMatTVecPacked(TilePtr(I, I), pDiag, t, x + I * t, y + I * t);
+		for (int J = I + 1; J < Blocks; J++)
+		{
+			const ValType *p = TilePtr(I, J);
+			for (int a = 0; a < t; a++)
+				AxpyRange(y + J * t, x[I * t + a], p + a * t, t);
+		}
+	}
+	TVector<ValType> r(Size);
+	copy_n(y, Size, r.GetData());
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+// Решение Ux = b: блочная обратная подстановка, из части решения для строки
+// плиток I вычитаются произведения плиток (I, J), J > I, на найденные
+// части, затем решается треугольная система диагональной плитки
+template <class ValType>
+TVector<ValType> TTiledMatrix<ValType>::Solve(const TVector<ValType> &b) const
+{
+	if (Size != b.GetSize())
+		throw "Error";
+	for (int i = 0; i < Size; i++)
+		if (pElem[Index(i, i)] == ValType(0))
+			throw "Singular matrix";
+	ValType (*dot)(const ValType*, const ValType*, int) = ScalarDot<ValType>;
+	if constexpr (TSimdSupported<ValType>::value)
+		dot = SimdKernels<ValType>().Dot;
+	const int t = Tile, n = Blocks * Tile;
+	unique_ptr<ValType[]> buf(new ValType[n]());
+	ValType *x = buf.get();
+	copy_n(b.GetData(), Size, x);
+	for (int I = Blocks - 1; I >= 0; I--)
+	{
+		ValType *xi = x + I * t;
+		for (int J = I + 1; J < Blocks; J++)
+		{
+			const ValType *p = TilePtr(I, J);
+			for (int a = 0; a < t; a++)
+				xi[a] = xi[a] - dot(p + a * t, x + J * t, t);
+		}
+		TriSolvePacked(TilePtr(I, I), pDiag, t, xi, 1);
+	}
+	TVector<ValType> r(Size);
+	copy_n(x, Size, r.GetData());
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+#endif
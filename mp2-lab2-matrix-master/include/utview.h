@@ -0,0 +1,760 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// utview.h
+//
+// Представления матриц без копирования данных.
+// TTransposedView - матрица U^T (нижнетреугольная) над буфером TMatrix U:
+// элемент (i, j), j <= i, - это элемент (j, i) матрицы U. Ядра выбирают
+// обход по строкам U: умножение U^T на вектор - TriMatTVecPacked, решение
+// U^T x = b - прямая подстановка TriSolveTransPacked. Элемент (i, j) в U^T
+// и элемент (j, i) в U занимают одну позицию упакованного буфера, поэтому
+// поэлементные выражения над представлениями (вид 3, см. TExprTraits)
+// вычисляются теми же ядрами, что и над матрицами.
+// TVectorSlice - отрезок подряд лежащих элементов (часть вектора, строка
+// матрицы), TColumnView - столбец матрицы (элементы строк 0..j с шагом,
+// уменьшающимся на 1 от строки к строке), TBlockView - прямоугольный блок
+// над диагональю или треугольный блок на диагонали. Представления вектора
+// участвуют в выражениях и свертках (utreduce.h) наравне с TVector,
+// блоки - построчно через TVectorSlice. Результат операций над
+// перекрывающимися со сдвигом представлениями не определен.
+// Представления константных данных имеют константный тип элементов
+// (TTransposedView<const T> и т.п.): они только читают данные, запись
+// через них не компилируется, а представление изменяемых данных
+// преобразуется в представление только для чтения.
+
+#ifndef __UTVIEW_H__
+#define __UTVIEW_H__
+
+#include <iostream>
+#include <memory>
+#include "utreduce.h"
+
+using namespace std;
+
+// Шаблон транспонированного представления; ValType = const T - только
+// для чтения
+template <class ValType>
+class TTransposedView
+{
+public:
+	typedef typename remove_const<ValType>::type Elem;
+	typedef typename conditional<is_const<ValType>::value,
+		const TMatrix<Elem>, TMatrix<Elem> >::type Matrix;
+private:
+	Matrix *pMatrix; // U
+public:
+	explicit TTransposedView(Matrix &mt) : pMatrix(&mt) {}
+	TTransposedView(const TTransposedView &v) = default;
+	template <class U, class = typename enable_if<is_same<const U, ValType>::value &&
+		!is_same<U, ValType>::value>::type>
+	TTransposedView(const TTransposedView<U> &v) : pMatrix(&v.Transposed()) {} // только чтение
+	int GetSize() const { return pMatrix->GetSize(); }
+	int GetStartIndex() const { return 0; }
+	const TMatrix<Elem>& Transposed() const { return *pMatrix; } // матрица U
+	ValType& operator()(int i, int j);             // элемент (i, j), j <= i
+	const ValType& operator()(int i, int j) const;
+	template <class U>
+	bool operator==(const TTransposedView<U> &v) const { return Transposed() == v.Transposed(); }
+	template <class U>
+	bool operator!=(const TTransposedView<U> &v) const { return !(*this == v); }
+	TTransposedView& operator=(const TTransposedView &v) // копирование элементов
+	{
+		return operator=<ValType>(v);
+	}
+	template <class U>
+	TTransposedView& operator=(const TTransposedView<U> &v);
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 3 && !TExprTraits<E>::Leaf, TTransposedView&>::type
+		operator=(const E &e);                     // вычисление выражения в буфер U
+
+	TVector<Elem> operator*(const TVector<Elem> &v) const;     // U^T * v
+	TVector<Elem> MulTransposed(const TVector<Elem> &v) const; // U * v
+	TVector<Elem> Solve(const TVector<Elem> &b) const;         // решение U^T x = b
+	TVector<TVector<Elem> > Solve(const TVector<TVector<Elem> > &b) const;
+
+	friend ostream& operator<<(ostream &out, const TTransposedView &v) // строка i -
+	{                                                                 // элементы 0..i
+		const TMatrix<Elem> &u = *v.pMatrix;
+		for (int i = 0; i < u.GetSize(); i++)
+		{
+			for (int j = 0; j <= i; j++)
+				out << u.GetData()[u.GetRowOffset(j) + i - j] << ' ';
+			out << '\n';
+		}
+		return out;
+	}
+};
+
+template <class ValType>
+struct TExprTraits<TTransposedView<ValType> >
+{
+	static const int Kind = 3;
+	static const bool Leaf = true;
+	typedef typename TTransposedView<ValType>::Elem Elem;
+	static const Elem& Get(const TTransposedView<ValType> &v, int k) { return v.Transposed().GetData()[k]; }
+	static const Elem* Data(const TTransposedView<ValType> &v) { return v.Transposed().GetData(); }
+	static int Length(const TTransposedView<ValType> &v) { return v.Transposed().GetPackedSize(); }
+};
+
+// Представление хранится в узлах выражений по значению (указатель на U),
+// поэтому выражение над временными представлениями Transpose(a) корректно
+template <class ValType>
+struct TExprRef<TTransposedView<ValType> >
+{
+	typedef const TTransposedView<ValType> Type;
+};
+
+// Представление U^T над матрицей mt; представление константной матрицы
+// только читает ее
+template <class ValType>
+TTransposedView<ValType> Transpose(TMatrix<ValType> &mt)
+{
+	return TTransposedView<ValType>(mt);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TTransposedView<const ValType> Transpose(const TMatrix<ValType> &mt)
+{
+	return TTransposedView<const ValType>(mt);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ
+ValType& TTransposedView<ValType>::operator()(int i, int j)
+{
+	return (*pMatrix)[j][i];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ к константному представлению
+const ValType& TTransposedView<ValType>::operator()(int i, int j) const
+{
+	return Transposed()[j][i];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class U> // присваивание: элементы v копируются в буфер U
+TTransposedView<ValType>& TTransposedView<ValType>::operator=(const TTransposedView<U> &v)
+{
+	static_assert(!is_const<ValType>::value, "view is read-only");
+	if (GetSize() != v.GetSize())
+		throw "Error";
+	if (pMatrix != &v.Transposed())
+	{
+		pMatrix->Detach(); // см. UTMATRIX_COW
+		copy_n(v.Transposed().pElem, pMatrix->GetPackedSize(), pMatrix->pElem);
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // вычисление выражения
+typename enable_if<TExprTraits<E>::Kind == 3 && !TExprTraits<E>::Leaf, TTransposedView<ValType>&>::type
+TTransposedView<ValType>::operator=(const E &e)
+{
+	static_assert(!is_const<ValType>::value, "view is read-only");
+	if (GetSize() != e.GetSize())
+		throw "Error";
+	pMatrix->Detach();
+	EvalExpr(pMatrix->pElem, e, pMatrix->GetPackedSize());
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // U^T * v: проход по строкам U
+TVector<typename TTransposedView<ValType>::Elem>
+TTransposedView<ValType>::operator*(const TVector<Elem> &v) const
+{
+	return pMatrix->MulTransposed(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // (U^T)^T * v = U * v
+TVector<typename TTransposedView<ValType>::Elem>
+TTransposedView<ValType>::MulTransposed(const TVector<Elem> &v) const
+{
+	return *pMatrix * v;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // решение U^T x = b
+TVector<typename TTransposedView<ValType>::Elem>
+TTransposedView<ValType>::Solve(const TVector<Elem> &b) const
+{
+	const TMatrix<Elem> &u = *pMatrix;
+	if (u.GetSize() != b.GetSize())
+		throw "Error";
+	for (int i = 0; i < u.GetSize(); i++)
+		if (u.pElem[u.pOffset[i]] == Elem(0))
+			throw "Singular matrix";
+	TVector<Elem> x(u.GetSize());
+	copy_n(b.GetData(), u.GetSize(), x.GetData());
+	TriSolveTransPacked(u.pElem, u.pOffset, u.GetSize(), x.GetData(), 1);
+	return x;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // решение U^T x = b для нескольких правых частей
+TVector<TVector<typename TTransposedView<ValType>::Elem> >
+TTransposedView<ValType>::Solve(const TVector<TVector<Elem> > &b) const
+{
+	const TMatrix<Elem> &u = *pMatrix;
+	int n = u.GetSize(), m = b.GetSize();
+	for (int c = 0; c < m; c++)
+		if (b.GetData()[c].GetSize() != n)
+			throw "Error";
+	for (int i = 0; i < n; i++)
+		if (u.pElem[u.pOffset[i]] == Elem(0))
+			throw "Singular matrix";
+	unique_ptr<Elem[]> buf(new Elem[size_t(n) * m]);
+	Elem *x = buf.get(); // правые части по строкам
+	for (int i = 0; i < n; i++)
+		for (int c = 0; c < m; c++)
+			x[size_t(i) * m + c] = b.GetData()[c].GetData()[i];
+	TriSolveTransPacked(u.pElem, u.pOffset, n, x, m);
+	TVector<TVector<Elem> > r = TMatrix<Elem>::NewVectors(m, n);
+	for (int c = 0; c < m; c++)
+	{
+		Elem *rc = r.GetData()[c].GetData();
+		for (int i = 0; i < n; i++)
+			rc[i] = x[size_t(i) * m + c];
+	}
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+  // Отрезок вектора
+
+// Шаблон отрезка; ValType = const T - только для чтения
+template <class ValType>
+class TVectorSlice
+{
+public:
+	typedef typename remove_const<ValType>::type Elem;
+	typedef typename conditional<is_const<ValType>::value,
+		const TVector<Elem>, TVector<Elem> >::type Vector;
+private:
+	ValType *pData;
+	int Size;
+public:
+	TVectorSlice(ValType *p, int s) : pData(p), Size(s) {}
+	TVectorSlice(Vector &v) : pData(v.GetData()), Size(v.GetSize()) {} // весь вектор
+	TVectorSlice(const TVectorSlice &s) = default;
+	template <class U, class = typename enable_if<is_same<const U, ValType>::value &&
+		!is_same<U, ValType>::value>::type>
+	TVectorSlice(const TVectorSlice<U> &s) : pData(s.GetData()), Size(s.GetSize()) {} // только чтение
+	int GetSize() const { return Size; }
+	int GetStartIndex() const { return 0; }
+	ValType* GetData() { return pData; }
+	const ValType* GetData() const { return pData; }
+	ValType* begin() { return pData; }             // итераторы STL
+	ValType* end() { return pData + Size; }
+	const ValType* begin() const { return pData; }
+	const ValType* end() const { return pData + Size; }
+	ValType& operator[](int pos);                  // доступ (см. UTMATRIX_BOUNDS_CHECK)
+	const ValType& operator[](int pos) const;
+	TVectorSlice& operator=(const TVectorSlice &s); // копирование элементов
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 1, TVectorSlice&>::type
+		operator=(const E &e);                     // вычисление выражения
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 1, TVectorSlice&>::type
+		operator+=(const E &e);
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 1, TVectorSlice&>::type
+		operator-=(const E &e);
+	TVectorSlice& operator*=(const Elem &val);
+	TVectorSlice& Axpy(const Elem &alpha, const TVectorSlice<const Elem> &x); // *this += alpha * x
+
+	friend ostream& operator<<(ostream &out, const TVectorSlice &s)
+	{
+		for (int i = 0; i < s.Size; i++)
+			out << s.pData[i] << ' ';
+		return out;
+	}
+};
+
+template <class ValType>
+struct TExprTraits<TVectorSlice<ValType> >
+{
+	static const int Kind = 1;
+	static const bool Leaf = false; // не владеет памятью; в узлах - по значению
+	typedef typename TVectorSlice<ValType>::Elem Elem;
+	static const Elem& Get(const TVectorSlice<ValType> &s, int k) { return s.GetData()[k]; }
+	static const Elem* Data(const TVectorSlice<ValType> &s) { return s.GetData(); }
+	static int Length(const TVectorSlice<ValType> &s) { return s.GetSize(); }
+};
+
+template <class ValType>
+struct IsDenseOperand<TVectorSlice<ValType> > : true_type {};
+
+// Элементы [from, to) вектора v в его индексах (с учетом StartIndex);
+// отрезок константного вектора только читает его
+template <class ValType>
+TVectorSlice<ValType> Slice(TVector<ValType> &v, int from, int to)
+{
+	if ((from < v.GetStartIndex()) || (to < from) || (to > v.GetStartIndex() + v.GetSize()))
+		throw "Index out of range";
+	return TVectorSlice<ValType>(v.GetData() + (from - v.GetStartIndex()), to - from);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TVectorSlice<const ValType> Slice(const TVector<ValType> &v, int from, int to)
+{
+	if ((from < v.GetStartIndex()) || (to < from) || (to > v.GetStartIndex() + v.GetSize()))
+		throw "Index out of range";
+	return TVectorSlice<const ValType>(v.GetData() + (from - v.GetStartIndex()), to - from);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // весь вектор
+TVectorSlice<ValType> Slice(TVector<ValType> &v)
+{
+	return TVectorSlice<ValType>(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TVectorSlice<const ValType> Slice(const TVector<ValType> &v)
+{
+	return TVectorSlice<const ValType>(v);
+} /*-------------------------------------------------------------------------*/
+
+// Элементы [from, to) отрезка s; отрезок константного отрезка только
+// читает элементы
+template <class ValType>
+TVectorSlice<ValType> Slice(TVectorSlice<ValType> &s, int from, int to)
+{
+	if ((from < 0) || (to < from) || (to > s.GetSize()))
+		throw "Index out of range";
+	return TVectorSlice<ValType>(s.GetData() + from, to - from);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // отрезок временного отрезка (Slice(Row(m, i), ...))
+TVectorSlice<ValType> Slice(TVectorSlice<ValType> &&s, int from, int to)
+{
+	return Slice(s, from, to);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TVectorSlice<const typename TVectorSlice<ValType>::Elem>
+Slice(const TVectorSlice<ValType> &s, int from, int to)
+{
+	if ((from < 0) || (to < from) || (to > s.GetSize()))
+		throw "Index out of range";
+	return TVectorSlice<const typename TVectorSlice<ValType>::Elem>(s.GetData() + from, to - from);
+} /*-------------------------------------------------------------------------*/
+
+// Хранимая часть строки i матрицы: элементы (i, i..n-1)
+template <class ValType>
+TVectorSlice<ValType> Row(TMatrix<ValType> &mt, int i)
+{
+	if ((i < 0) || (i >= mt.GetSize()))
+		throw "Index out of range";
+	return TVectorSlice<ValType>(mt.GetData() + mt.GetRowOffset(i), mt.GetSize() - i);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TVectorSlice<const ValType> Row(const TMatrix<ValType> &mt, int i)
+{
+	if ((i < 0) || (i >= mt.GetSize()))
+		throw "Index out of range";
+	return TVectorSlice<const ValType>(mt.GetData() + mt.GetRowOffset(i), mt.GetSize() - i);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ
+ValType& TVectorSlice<ValType>::operator[](int pos)
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < 0) || (pos >= Size))
+		throw "Index out of range";
+#endif
+	return pData[pos];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ к константному отрезку
+const ValType& TVectorSlice<ValType>::operator[](int pos) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < 0) || (pos >= Size))
+		throw "Index out of range";
+#endif
+	return pData[pos];
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // копирование элементов
+TVectorSlice<ValType>& TVectorSlice<ValType>::operator=(const TVectorSlice<ValType> &s)
+{
+	return operator=<TVectorSlice>(s);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // вычисление выражения
+typename enable_if<TExprTraits<E>::Kind == 1, TVectorSlice<ValType>&>::type
+TVectorSlice<ValType>::operator=(const E &e)
+{
+	static_assert(!is_const<ValType>::value, "slice is read-only");
+	if (Size != e.GetSize())
+		throw "Error";
+	if constexpr (IsDenseOperand<E>::value)
+	{
+		const ValType *p = TExprTraits<E>::Data(e);
+		if (p != pData)
+			copy_n(p, Size, pData);
+	}
+	else
+		EvalExpr(pData, e, Size);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // сложение на месте
+typename enable_if<TExprTraits<E>::Kind == 1, TVectorSlice<ValType>&>::type
+TVectorSlice<ValType>::operator+=(const E &e)
+{
+	EvalExpr(pData, TBinExpr<TVectorSlice, E, TOpAdd>(*this, e), Size);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // вычитание на месте
+typename enable_if<TExprTraits<E>::Kind == 1, TVectorSlice<ValType>&>::type
+TVectorSlice<ValType>::operator-=(const E &e)
+{
+	EvalExpr(pData, TBinExpr<TVectorSlice, E, TOpSub>(*this, e), Size);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение на скаляр на месте
+TVectorSlice<ValType>& TVectorSlice<ValType>::operator*=(const Elem &val)
+{
+	EvalExpr(pData, TScalarExpr<TVectorSlice, TOpMul>(*this, val), Size);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // *this += alpha * x
+TVectorSlice<ValType>& TVectorSlice<ValType>::Axpy(const Elem &alpha, const TVectorSlice<const Elem> &x)
+{
+	if (Size != x.GetSize())
+		throw "Error";
+	AxpyRange(pData, alpha, x.GetData(), Size);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+  // Столбец матрицы
+
+// Шаблон столбца; ValType = const T - только для чтения
+template <class ValType>
+class TColumnView
+{
+public:
+	typedef typename remove_const<ValType>::type Elem;
+private:
+	ValType *pElem;       // буфер матрицы
+	const int *pOffset;   // смещения строк матрицы
+	int Col;              // номер столбца; элементы - строки 0..Col
+	template <class U> friend class TColumnView;
+public:
+	TColumnView(ValType *p, const int *off, int j) : pElem(p), pOffset(off), Col(j) {}
+	TColumnView(const TColumnView &c) = default;
+	template <class U, class = typename enable_if<is_same<const U, ValType>::value &&
+		!is_same<U, ValType>::value>::type>
+	TColumnView(const TColumnView<U> &c) : pElem(c.pElem), pOffset(c.pOffset), Col(c.Col) {} // только чтение
+	int GetSize() const { return Col + 1; }
+	int GetStartIndex() const { return 0; }
+	ValType& operator[](int pos);                  // элемент (pos, Col)
+	const ValType& operator[](int pos) const;
+	ValType& at_unchecked(int pos) { return pElem[pOffset[pos] + Col - pos]; }
+	const ValType& at_unchecked(int pos) const { return pElem[pOffset[pos] + Col - pos]; }
+	TColumnView& operator=(const TColumnView &c);  // копирование элементов
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 1, TColumnView&>::type
+		operator=(const E &e);                     // вычисление выражения
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 1, TColumnView&>::type
+		operator+=(const E &e) { return *this = TBinExpr<TColumnView, E, TOpAdd>(*this, e); }
+	template <class E>
+	typename enable_if<TExprTraits<E>::Kind == 1, TColumnView&>::type
+		operator-=(const E &e) { return *this = TBinExpr<TColumnView, E, TOpSub>(*this, e); }
+	TColumnView& operator*=(const Elem &val) { return *this = TScalarExpr<TColumnView, TOpMul>(*this, val); }
+
+	friend ostream& operator<<(ostream &out, const TColumnView &c)
+	{
+		for (int i = 0; i <= c.Col; i++)
+			out << c.at_unchecked(i) << ' ';
+		return out;
+	}
+};
+
+template <class ValType>
+struct TExprTraits<TColumnView<ValType> >
+{
+	static const int Kind = 1;
+	static const bool Leaf = false;
+	typedef typename TColumnView<ValType>::Elem Elem;
+	static const Elem& Get(const TColumnView<ValType> &c, int k) { return c.at_unchecked(k); }
+	static int Length(const TColumnView<ValType> &c) { return c.GetSize(); }
+};
+
+// Столбец j матрицы: элементы (0..j, j)
+template <class ValType>
+TColumnView<ValType> Column(TMatrix<ValType> &mt, int j)
+{
+	if ((j < 0) || (j >= mt.GetSize()))
+		throw "Index out of range";
+	ValType *p = mt.GetData(); // до GetRowOffsets: при UTMATRIX_COW буфер отделяется
+	return TColumnView<ValType>(p, mt.GetRowOffsets(), j);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TColumnView<const ValType> Column(const TMatrix<ValType> &mt, int j)
+{
+	if ((j < 0) || (j >= mt.GetSize()))
+		throw "Index out of range";
+	return TColumnView<const ValType>(mt.GetData(), mt.GetRowOffsets(), j);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ
+ValType& TColumnView<ValType>::operator[](int pos)
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < 0) || (pos > Col))
+		throw "Index out of range";
+#endif
+	return at_unchecked(pos);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // доступ к константному столбцу
+const ValType& TColumnView<ValType>::operator[](int pos) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((pos < 0) || (pos > Col))
+		throw "Index out of range";
+#endif
+	return at_unchecked(pos);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // копирование элементов
+TColumnView<ValType>& TColumnView<ValType>::operator=(const TColumnView<ValType> &c)
+{
+	return operator=<TColumnView>(c);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class E> // вычисление выражения: проход по строкам
+typename enable_if<TExprTraits<E>::Kind == 1, TColumnView<ValType>&>::type
+TColumnView<ValType>::operator=(const E &e)
+{
+	static_assert(!is_const<ValType>::value, "column is read-only");
+	if (GetSize() != e.GetSize())
+		throw "Error";
+	for (int i = 0; i <= Col; i++)
+		at_unchecked(i) = TExprTraits<E>::Get(e, i);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+  // Блок матрицы
+
+// Блок строк [r0, r0 + rows) и столбцов [c0, c0 + cols): прямоугольный
+// (целиком над диагональю, r0 + rows - 1 <= c0) или треугольный
+// (диагональный, r0 = c0, rows = cols). Строки блока - отрезки подряд
+// лежащих элементов, операции выполняются построчно ядрами utsimd.h;
+// ValType = const T - только для чтения
+template <class ValType>
+class TBlockView
+{
+public:
+	typedef typename remove_const<ValType>::type Elem;
+private:
+	ValType *pElem;
+	const int *pOffset;
+	int Row0, Col0, Rows, Cols;
+	bool Triangular;
+	template <class U> friend class TBlockView;
+
+	int RowIndex(int a) const;                     // начало строки a в буфере
+	int Index(int a, int b) const;                 // элемент (a, b) в буфере
+public:
+	TBlockView(ValType *p, const int *off, int r0, int c0, int rows, int cols, bool tri) :
+		pElem(p), pOffset(off), Row0(r0), Col0(c0), Rows(rows), Cols(cols), Triangular(tri) {}
+	TBlockView(const TBlockView &bv) = default;
+	template <class U, class = typename enable_if<is_same<const U, ValType>::value &&
+		!is_same<U, ValType>::value>::type>
+	TBlockView(const TBlockView<U> &bv) : pElem(bv.pElem), pOffset(bv.pOffset), Row0(bv.Row0),
+		Col0(bv.Col0), Rows(bv.Rows), Cols(bv.Cols), Triangular(bv.Triangular) {} // только чтение
+	int GetRows() const { return Rows; }
+	int GetCols() const { return Cols; }
+	bool IsTriangular() const { return Triangular; }
+	int GetRowStart(int a) const { return Triangular ? a : 0; } // первый столбец строки a
+	TVectorSlice<ValType> Row(int a)               // хранимая часть строки a блока
+	{
+		return TVectorSlice<ValType>(pElem + RowIndex(a), Cols - GetRowStart(a));
+	}
+	TVectorSlice<const Elem> Row(int a) const
+	{
+		return TVectorSlice<const Elem>(pElem + RowIndex(a), Cols - GetRowStart(a));
+	}
+	ValType& operator()(int a, int b) { return pElem[Index(a, b)]; } // элемент (r0 + a, c0 + b)
+	const ValType& operator()(int a, int b) const { return pElem[Index(a, b)]; }
+	template <class U>
+	bool operator==(const TBlockView<U> &bv) const;
+	template <class U>
+	bool operator!=(const TBlockView<U> &bv) const { return !(*this == bv); }
+	TBlockView& operator=(const TBlockView &bv)    // копирование элементов
+	{
+		return operator=<ValType>(bv);
+	}
+	template <class U>
+	TBlockView& operator=(const TBlockView<U> &bv);
+	template <class U>
+	TBlockView& operator+=(const TBlockView<U> &bv);
+	template <class U>
+	TBlockView& operator-=(const TBlockView<U> &bv);
+	TBlockView& operator*=(const Elem &val);
+	template <class U>
+	TBlockView& Axpy(const Elem &alpha, const TBlockView<U> &bv); // *this += alpha * bv
+	void MulAdd(const TVectorSlice<const Elem> &x, TVectorSlice<Elem> y) const; // y += B * x
+
+	friend ostream& operator<<(ostream &out, const TBlockView &bv)
+	{
+		for (int a = 0; a < bv.Rows; a++)
+			out << bv.Row(a) << '\n';
+		return out;
+	}
+};
+
+// Блок матрицы mt: строки [r0, r0 + rows), столбцы [c0, c0 + cols);
+// блок константной матрицы только читает ее
+template <class ValType>
+TBlockView<ValType> Block(TMatrix<ValType> &mt, int r0, int c0, int rows, int cols)
+{
+	if ((r0 < 0) || (c0 < 0) || (rows < 0) || (cols < 0) ||
+		(r0 + rows > mt.GetSize()) || (c0 + cols > mt.GetSize()))
+		throw "Index out of range";
+	bool tri = (r0 == c0) && (rows == cols);
+	if (!tri && (rows > 0) && (r0 + rows - 1 > c0))
+		throw "Error"; // блок пересекает диагональ
+	ValType *p = mt.GetData(); // до GetRowOffsets (см. Column)
+	return TBlockView<ValType>(p, mt.GetRowOffsets(), r0, c0, rows, cols, tri);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType>
+TBlockView<const ValType> Block(const TMatrix<ValType> &mt, int r0, int c0, int rows, int cols)
+{
+	if ((r0 < 0) || (c0 < 0) || (rows < 0) || (cols < 0) ||
+		(r0 + rows > mt.GetSize()) || (c0 + cols > mt.GetSize()))
+		throw "Index out of range";
+	bool tri = (r0 == c0) && (rows == cols);
+	if (!tri && (rows > 0) && (r0 + rows - 1 > c0))
+		throw "Error"; // блок пересекает диагональ
+	return TBlockView<const ValType>(mt.GetData(), mt.GetRowOffsets(), r0, c0, rows, cols, tri);
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // начало строки a
+int TBlockView<ValType>::RowIndex(int a) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((a < 0) || (a >= Rows))
+		throw "Index out of range";
+#endif
+	int i = Row0 + a, j = Col0 + GetRowStart(a);
+	return pOffset[i] + j - i;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // элемент (a, b)
+int TBlockView<ValType>::Index(int a, int b) const
+{
+#if UTMATRIX_BOUNDS_CHECK
+	if ((a < 0) || (a >= Rows) || (b < GetRowStart(a)) || (b >= Cols))
+		throw "Index out of range";
+#endif
+	int i = Row0 + a, j = Col0 + b;
+	return pOffset[i] + j - i;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class U> // сравнение
+bool TBlockView<ValType>::operator==(const TBlockView<U> &bv) const
+{
+	if ((Rows != bv.Rows) || (Cols != bv.Cols) || (Triangular != bv.Triangular))
+		return false;
+	for (int a = 0; a < Rows; a++)
+		if (!equal(Row(a).GetData(), Row(a).GetData() + Row(a).GetSize(), bv.Row(a).GetData()))
+			return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class U> // копирование элементов
+TBlockView<ValType>& TBlockView<ValType>::operator=(const TBlockView<U> &bv)
+{
+	static_assert(!is_const<ValType>::value, "block is read-only");
+	if ((Rows != bv.Rows) || (Cols != bv.Cols) || (Triangular != bv.Triangular))
+		throw "Error";
+	for (int a = 0; a < Rows; a++)
+		Row(a) = bv.Row(a);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class U> // сложение на месте
+TBlockView<ValType>& TBlockView<ValType>::operator+=(const TBlockView<U> &bv)
+{
+	if ((Rows != bv.Rows) || (Cols != bv.Cols) || (Triangular != bv.Triangular))
+		throw "Error";
+	for (int a = 0; a < Rows; a++)
+		Row(a) += bv.Row(a);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class U> // вычитание на месте
+TBlockView<ValType>& TBlockView<ValType>::operator-=(const TBlockView<U> &bv)
+{
+	if ((Rows != bv.Rows) || (Cols != bv.Cols) || (Triangular != bv.Triangular))
+		throw "Error";
+	for (int a = 0; a < Rows; a++)
+		Row(a) -= bv.Row(a);
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // умножение на скаляр на месте
+TBlockView<ValType>& TBlockView<ValType>::operator*=(const Elem &val)
+{
+	for (int a = 0; a < Rows; a++)
+		Row(a) *= val;
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> template <class U> // *this += alpha * bv
+TBlockView<ValType>& TBlockView<ValType>::Axpy(const Elem &alpha, const TBlockView<U> &bv)
+{
+	if ((Rows != bv.Rows) || (Cols != bv.Cols) || (Triangular != bv.Triangular))
+		throw "Error";
+	for (int a = 0; a < Rows; a++)
+		Row(a).Axpy(alpha, bv.Row(a));
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // y += B * x: строка блока - скалярное произведение
+void TBlockView<ValType>::MulAdd(const TVectorSlice<const Elem> &x, TVectorSlice<Elem> y) const
+{
+	if ((x.GetSize() != Cols) || (y.GetSize() != Rows))
+		throw "Error";
+	for (int a = 0; a < Rows; a++)
+		y.GetData()[a] = y.GetData()[a] +
+			Row(a) * Slice(x, GetRowStart(a), Cols);
+} /*-------------------------------------------------------------------------*/
+
+  // Свертки блока: строки сворачиваются как векторы (utreduce.h), итоги
+  // строк складываются по порядку
+
+template <class ValType> // сумма элементов
+typename TBlockView<ValType>::Elem Sum(const TBlockView<ValType> &bv)
+{
+	typename TBlockView<ValType>::Elem s(0);
+	for (int a = 0; a < bv.GetRows(); a++)
+		s = s + Sum(bv.Row(a));
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // максимум модуля
+typename TBlockView<ValType>::Elem MaxAbs(const TBlockView<ValType> &bv)
+{
+	typename TBlockView<ValType>::Elem s(0);
+	for (int a = 0; a < bv.GetRows(); a++)
+		s = TOpMax::Apply(s, MaxAbs(bv.Row(a)));
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class ValType> // норма Фробениуса
+auto NormFrobenius(const TBlockView<ValType> &bv) -> decltype(sqrt(typename TBlockView<ValType>::Elem()))
+{
+	typename TBlockView<ValType>::Elem s(0);
+	for (int a = 0; a < bv.GetRows(); a++)
+		s = s + ReduceVector<TOpAdd, TMapSqr>(bv.Row(a));
+	return sqrt(s);
+} /*-------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,165 @@
+#include "utbatch.h"
+
+#include <gtest.h>
+#include "test_matrices.h"
+
+template <class T>
+TMatrixBatch<T> MakeBatch(int n, int count, int seed)
+{
+	TMatrixBatch<T> mb(n, count);
+	for (int b = 0; b < count; b++)
+		mb.Set(b, MakeTestMatrix<T>(n, b + seed));
+	return mb;
+}
+
+template <class T>
+TVectorBatch<T> MakeVectorBatch(int n, int count)
+{
+	TVectorBatch<T> vb(n, count);
+	for (int b = 0; b < count; b++)
+		for (int k = 0; k < n; k++)
+			vb(b, k) = T((b + 3 * k) % 7 - 3);
+	return vb;
+}
+
+TEST(TMatrixBatch, can_create_batch)
+{
+	ASSERT_NO_THROW(TMatrixBatch<int> mb(4, 100));
+	ASSERT_NO_THROW(TMatrixBatch<int> mb(4, 0));
+	ASSERT_ANY_THROW(TMatrixBatch<int> mb(-1, 5));
+	ASSERT_ANY_THROW(TMatrixBatch<int> mb(3, -5));
+}
+
+TEST(TMatrixBatch, element_of_all_matrices_is_stored_contiguously)
+{
+	TMatrixBatch<double> mb(3, 10);
+	EXPECT_EQ(0, mb.GetStride() % 8);
+	EXPECT_LE(10, mb.GetStride());
+	mb(4, 1, 2) = 5;
+	EXPECT_EQ(5, mb.GetLanes(1, 2)[4]);
+	EXPECT_EQ(mb.GetLanes(0, 0) + 4 * mb.GetStride(), mb.GetLanes(1, 2));
+}
+
+TEST(TMatrixBatch, const_access_reads_same_element)
+{
+	TMatrixBatch<double> mb(3, 10);
+	TVectorBatch<double> vb(3, 10);
+	mb(4, 1, 2) = 5;
+	vb(7, 2) = 6;
+	const TMatrixBatch<double> &cm = mb;
+	const TVectorBatch<double> &cv = vb;
+	EXPECT_EQ(&mb(4, 1, 2), &cm(4, 1, 2));
+	EXPECT_EQ(6, cv(7, 2));
+	EXPECT_EQ(&vb(7, 2), &cv(7, 2));
+	EXPECT_TRUE((is_same<decltype(cm(0, 0, 0)), const double&>::value));
+}
+
+#if UTMATRIX_BOUNDS_CHECK
+TEST(TMatrixBatch, throws_when_index_is_out_of_range)
+{
+	TMatrixBatch<int> mb(3, 4);
+	ASSERT_ANY_THROW(mb(4, 0, 0));
+	ASSERT_ANY_THROW(mb(0, 1, 0));
+	ASSERT_ANY_THROW(mb(0, 0, 3));
+	const TMatrixBatch<int> &c = mb;
+	ASSERT_ANY_THROW(c(0, 1, 0));
+	const TVectorBatch<int> vb(3, 4);
+	ASSERT_ANY_THROW(vb(4, 0));
+	ASSERT_ANY_THROW(vb(0, 3));
+}
+#endif
+
+TEST(TMatrixBatch, can_set_and_get_matrices)
+{
+	TMatrixBatch<int> mb = MakeBatch<int>(5, 7, 0);
+	for (int b = 0; b < 7; b++)
+		EXPECT_EQ(MakeTestMatrix<int>(5, b), mb.Get(b));
+	ASSERT_ANY_THROW(mb.Set(0, TMatrix<int>(4)));
+	ASSERT_ANY_THROW(mb.Get(7));
+}
+
+TEST(TMatrixBatch, copied_batch_is_equal_and_has_own_memory)
+{
+	TMatrixBatch<int> mb = MakeBatch<int>(4, 9, 0), c(mb);
+	EXPECT_EQ(mb, c);
+	c(8, 0, 3) = 100;
+	EXPECT_NE(mb, c);
+	c = mb;
+	EXPECT_EQ(mb, c);
+}
+
+TEST(TMatrixBatch, batched_operations_match_each_matrix)
+{
+	for (int n : { 1, 3, 8 })
+		for (int count : { 1, 63, 257, 600 })
+		{
+			TMatrixBatch<int> a = MakeBatch<int>(n, count, 0), b = MakeBatch<int>(n, count, 2);
+			TVectorBatch<int> x = MakeVectorBatch<int>(n, count);
+			TMatrixBatch<int> s = a + b, d = a - b, p = a * b, t = a;
+			t *= 3;
+			TVectorBatch<int> y = a * x;
+			for (int k = 0; k < count; k++)
+			{
+				TMatrix<int> ak = a.Get(k), bk = b.Get(k);
+				EXPECT_EQ(ak + bk, s.Get(k));
+				EXPECT_EQ(ak - bk, d.Get(k));
+				EXPECT_EQ(ak * bk, p.Get(k));
+				EXPECT_EQ(ak * 3, t.Get(k));
+				EXPECT_EQ(ak * x.Get(k), y.Get(k));
+			}
+		}
+}
+
+TEST(TMatrixBatch, mul_add_accumulates_product_in_place)
+{
+	TMatrixBatch<int> a = MakeBatch<int>(4, 70, 0), b = MakeBatch<int>(4, 70, 1), c = a;
+	c.MulAdd(a, b);
+	for (int k = 0; k < 70; k++)
+		EXPECT_EQ(a.Get(k) + a.Get(k) * b.Get(k), c.Get(k));
+	ASSERT_ANY_THROW(c.MulAdd(c, b));
+}
+
+TEST(TMatrixBatch, throws_when_batches_do_not_match)
+{
+	TMatrixBatch<int> a(3, 10), b(3, 11), c(4, 10);
+	TVectorBatch<int> x(3, 11);
+	ASSERT_ANY_THROW(a + b);
+	ASSERT_ANY_THROW(a * c);
+	ASSERT_ANY_THROW(a * x);
+	ASSERT_ANY_THROW(a.Solve(x));
+}
+
+TEST(TMatrixBatch, can_solve_batch_of_systems)
+{
+	const int n = 6, count = 150;
+	TMatrixBatch<double> a = MakeBatch<double>(n, count, 1);
+	TVectorBatch<double> x = MakeVectorBatch<double>(n, count);
+	TVectorBatch<double> y = a.Solve(a * x);
+	for (int b = 0; b < count; b++)
+		for (int k = 0; k < n; k++)
+			EXPECT_NEAR(x(b, k), y(b, k), 1e-12);
+}
+
+TEST(TMatrixBatch, throws_when_any_system_is_singular)
+{
+	TMatrixBatch<double> a = MakeBatch<double>(3, 20, 0);
+	a(17, 2, 2) = 0;
+	ASSERT_ANY_THROW(a.Solve(TVectorBatch<double>(3, 20)));
+}
+
+TEST(TMatrixBatch, parallel_operations_match_serial)
+{
+	TMatrixBatch<double> a = MakeBatch<double>(5, 3000, 0), b = MakeBatch<double>(5, 3000, 1);
+	TVectorBatch<double> x = MakeVectorBatch<double>(5, 3000);
+	TMatrixBatch<double> sp = a * b;
+	TVectorBatch<double> ss = a.Solve(x);
+	int threads = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(4);
+	SetParallelCutoff(0);
+	TMatrixBatch<double> pp = a * b;
+	TVectorBatch<double> ps = a.Solve(x);
+	SetNumThreads(threads);
+	SetParallelCutoff(cutoff);
+	EXPECT_EQ(sp, pp);
+	EXPECT_EQ(ss, ps);
+}
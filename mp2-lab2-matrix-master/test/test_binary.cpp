@@ -0,0 +1,173 @@
+#include "utbinary.h"
+
+#include <gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <sstream>
+
+static TMatrix<double> MakeBinaryMatrix(int s)
+{
+	TMatrix<double> m(s);
+	for (int i = 0; i < s; i++)
+		for (int j = i; j < s; j++)
+			m[i][j] = i + 0.25 * j;
+	return m;
+}
+
+TEST(TBinary, header_is_64_bytes_and_type_codes_differ)
+{
+	EXPECT_EQ(64u, sizeof(TBinaryHeader));
+	EXPECT_NE(TBinaryType<int>::Code, TBinaryType<unsigned>::Code);
+	EXPECT_NE(TBinaryType<float>::Code, TBinaryType<double>::Code);
+	EXPECT_NE(TBinaryType<int>::Code, TBinaryType<long long>::Code);
+	EXPECT_EQ(0, TBinaryType<bool>::Code);
+}
+
+TEST(TBinary, can_write_and_read_matrix)
+{
+	TMatrix<double> m = MakeBinaryMatrix(37), r(2);
+	stringstream s(ios::in | ios::out | ios::binary);
+	WriteBinary(s, m);
+	EXPECT_EQ(64 + 37 * 38 / 2 * sizeof(double), s.str().size());
+	ReadBinary(s, r);
+	EXPECT_EQ(m, r);
+}
+
+TEST(TBinary, can_write_and_read_vector_with_start_index)
+{
+	TVector<int> v(10, 3), r;
+	for (int i = 3; i < 13; i++)
+		v[i] = i * i;
+	stringstream s(ios::in | ios::out | ios::binary);
+	WriteBinary(s, v);
+	ReadBinary(s, r);
+	EXPECT_EQ(v, r);
+	EXPECT_EQ(3, r.GetStartIndex());
+}
+
+TEST(TBinary, throws_on_type_mismatch)
+{
+	stringstream s(ios::in | ios::out | ios::binary);
+	WriteBinary(s, MakeBinaryMatrix(4));
+	TMatrix<float> mf;
+	ASSERT_ANY_THROW(ReadBinary(s, mf));
+	s.seekg(0);
+	TVector<double> v;
+	ASSERT_ANY_THROW(ReadBinary(s, v));
+}
+
+TEST(TBinary, throws_on_corrupted_data)
+{
+	stringstream s(ios::in | ios::out | ios::binary);
+	WriteBinary(s, MakeBinaryMatrix(5));
+	string data = s.str();
+	data[70] ^= 1;
+	stringstream c(data, ios::in | ios::binary);
+	TMatrix<double> r;
+	ASSERT_ANY_THROW(ReadBinary(c, r));
+}
+
+TEST(TBinary, throws_on_truncated_data)
+{
+	stringstream s(ios::in | ios::out | ios::binary);
+	WriteBinary(s, MakeBinaryMatrix(5));
+	stringstream c(s.str().substr(0, 100), ios::in | ios::binary);
+	TMatrix<double> r;
+	ASSERT_ANY_THROW(ReadBinary(c, r));
+}
+
+TEST(TBinary, can_read_file_with_foreign_byte_order)
+{
+	TMatrix<int> m(6);
+	for (int i = 0; i < 6; i++)
+		for (int j = i; j < 6; j++)
+			m[i][j] = 1000 * i + j;
+	stringstream s(ios::in | ios::out | ios::binary);
+	WriteBinary(s, m);
+	string data = s.str(); // перевод файла в другой порядок байт
+	TBinaryHeader h;
+	memcpy(&h, data.data(), sizeof(h));
+	h.Checksum = 0;
+	SwapBytes(&h.ByteOrder, 2, 1);
+	SwapBytes(&h.Version, 2, 1);
+	SwapBytes(&h.ElemSize, 2, 1);
+	SwapBytes(&h.Size, 8, 1);
+	SwapBytes(&h.StartIndex, 8, 1);
+	SwapBytes(&h.Count, 8, 1);
+	SwapBytes(&h.DataOffset, 8, 1);
+	SwapBytes(&data[64], sizeof(int), 21);
+	uint64_t sum = BinaryChecksum(&data[64], 21 * sizeof(int), BinaryChecksum(&h, sizeof(h)));
+	SwapBytes(&sum, 8, 1);
+	h.Checksum = sum;
+	memcpy(&data[0], &h, sizeof(h));
+	stringstream c(data, ios::in | ios::binary);
+	TMatrix<int> r;
+	ReadBinary(c, r);
+	EXPECT_EQ(m, r);
+}
+
+TEST(TBinary, can_map_matrix_file_without_copy)
+{
+	const char *name = "test_binary_matrix.tmp";
+	TMatrix<double> m = MakeBinaryMatrix(300);
+	SaveBinary(name, m);
+	{
+		TMappedMatrix<double> mm(name, true);
+		EXPECT_TRUE(mm.Verify());
+		EXPECT_EQ(m, mm.Get());
+		EXPECT_EQ(0u, size_t(mm.Get().GetData()) % 64);
+		TMatrix<double> sum(mm.Get() + m), twice(m * 2.0);
+		EXPECT_EQ(twice, sum);
+		TVector<double> x(300);
+		for (int i = 0; i < 300; i++)
+			x[i] = 1.0;
+		EXPECT_EQ(m * x, mm.Get() * x);
+	}
+	TMatrix<double> r;
+	LoadBinary(name, r);
+	EXPECT_EQ(m, r);
+	remove(name);
+}
+
+TEST(TBinary, can_map_vector_file)
+{
+	const char *name = "test_binary_vector.tmp";
+	TVector<float> v(1000, 2);
+	for (int i = 2; i < 1002; i++)
+		v[i] = 0.5f * i;
+	SaveBinary(name, v);
+	{
+		TMappedVector<float> mv(name, true);
+		EXPECT_EQ(v, mv.Get());
+		EXPECT_EQ(2, mv.Get().GetStartIndex());
+	}
+	remove(name);
+}
+
+TEST(TBinary, mapping_rejects_data_offset_outside_file)
+{
+	const char *name = "test_binary_offset.tmp";
+	stringstream s(ios::in | ios::out | ios::binary);
+	WriteBinary(s, MakeBinaryMatrix(4));
+	string data = s.str();
+	for (uint64_t offset : { uint64_t(0) - 64, uint64_t(data.size()) + 8 })
+	{
+		memcpy(&data[offsetof(TBinaryHeader, DataOffset)], &offset, sizeof(offset));
+		FILE *f = fopen(name, "wb");
+		ASSERT_TRUE(f != nullptr);
+		fwrite(data.data(), 1, data.size(), f);
+		fclose(f);
+		ASSERT_ANY_THROW(TMappedMatrix<double> mm(name)); // без проверки суммы
+	}
+	remove(name);
+}
+
+TEST(TBinary, mapping_rejects_wrong_type_and_missing_file)
+{
+	const char *name = "test_binary_type.tmp";
+	SaveBinary(name, MakeBinaryMatrix(3));
+	ASSERT_ANY_THROW(TMappedMatrix<float> mm(name));
+	ASSERT_ANY_THROW(TMappedVector<double> mv(name));
+	remove(name);
+	ASSERT_ANY_THROW(TMappedMatrix<double> mm(name));
+}
@@ -0,0 +1,170 @@
+#include "utcolmatrix.h"
+
+#include <gtest.h>
+#include <sstream>
+
+TEST(TColMatrix, can_create_matrix_with_positive_length)
+{
+	ASSERT_NO_THROW(TColMatrix<int> m(5));
+}
+
+TEST(TColMatrix, throws_when_create_matrix_with_negative_length)
+{
+	ASSERT_ANY_THROW(TColMatrix<int> m(-5));
+}
+
+TEST(TColMatrix, new_matrix_is_zero)
+{
+	TColMatrix<int> m(4);
+	for (int i = 0; i < 4; i++)
+		for (int j = i; j < 4; j++)
+			EXPECT_EQ(0, m[i][j]);
+}
+
+TEST(TColMatrix, can_set_and_get_element)
+{
+	TColMatrix<int> m(4);
+	m[1][3] = 7;
+	m[2][2] = 5;
+	EXPECT_EQ(7, m[1][3]);
+	EXPECT_EQ(5, m[2][2]);
+	EXPECT_EQ(0, m[1][2]);
+}
+
+TEST(TColMatrix, columns_are_stored_contiguously)
+{
+	TColMatrix<int> m(3);
+	m[0][2] = 1;
+	m[1][2] = 2;
+	m[2][2] = 3;
+	const int *col = m.GetData() + m.GetColOffset(2);
+	EXPECT_EQ(1, col[0]);
+	EXPECT_EQ(2, col[1]);
+	EXPECT_EQ(3, col[2]);
+}
+
+#if UTMATRIX_BOUNDS_CHECK
+TEST(TColMatrix, throws_when_access_below_diagonal_or_out_of_range)
+{
+	TColMatrix<int> m(3);
+	ASSERT_ANY_THROW(m[2][1]);
+	ASSERT_ANY_THROW(m[0][3]);
+	ASSERT_ANY_THROW(m[3][3]);
+	ASSERT_ANY_THROW(m[-1][0]);
+}
+#endif
+
+TEST(TColMatrix, row_reports_size_and_start_index_like_tmatrix_row)
+{
+	TColMatrix<int> m(5);
+	TMatrix<int> r(5);
+	EXPECT_EQ(r[2].GetSize(), m[2].GetSize());
+	EXPECT_EQ(r[2].GetStartIndex(), m[2].GetStartIndex());
+}
+
+TEST(TColMatrix, conversion_to_and_from_row_packing_is_exact)
+{
+	TMatrix<int> m(6);
+	for (int i = 0; i < 6; i++)
+		for (int j = i; j < 6; j++)
+			m[i][j] = 10 * i + j;
+	TColMatrix<int> c(m);
+	for (int i = 0; i < 6; i++)
+		for (int j = i; j < 6; j++)
+			EXPECT_EQ(m[i][j], c[i][j]);
+	EXPECT_EQ(m, c.ToMatrix());
+}
+
+TEST(TColMatrix, copied_matrix_is_equal_and_has_own_memory)
+{
+	TColMatrix<int> m(3);
+	m[0][1] = 4;
+	TColMatrix<int> c(m);
+	EXPECT_EQ(m, c);
+	c[0][1] = 5;
+	EXPECT_NE(m, c);
+}
+
+TEST(TColMatrix, can_assign_matrix_of_different_size)
+{
+	TColMatrix<int> m(3), c(5);
+	m[1][2] = 9;
+	c = m;
+	EXPECT_EQ(3, c.GetSize());
+	EXPECT_EQ(m, c);
+}
+
+TEST(TColMatrix, append_dimension_adds_zero_column_and_keeps_elements)
+{
+	TColMatrix<int> m(2);
+	m[0][0] = 1;
+	m[0][1] = 2;
+	m[1][1] = 3;
+	m.AppendDimension();
+	ASSERT_EQ(3, m.GetSize());
+	EXPECT_EQ(1, m[0][0]);
+	EXPECT_EQ(2, m[0][1]);
+	EXPECT_EQ(3, m[1][1]);
+	for (int i = 0; i < 3; i++)
+		EXPECT_EQ(0, m[i][2]);
+}
+
+TEST(TColMatrix, can_append_column)
+{
+	TColMatrix<int> m(0);
+	for (int n = 0; n < 20; n++)
+	{
+		TVector<int> col(n + 1);
+		for (int i = 0; i <= n; i++)
+			col[i] = 100 * i + n;
+		m.AppendDimension(col);
+	}
+	ASSERT_EQ(20, m.GetSize());
+	for (int i = 0; i < 20; i++)
+		for (int j = i; j < 20; j++)
+			EXPECT_EQ(100 * i + j, m[i][j]);
+}
+
+TEST(TColMatrix, throws_when_append_column_with_wrong_size)
+{
+	TColMatrix<int> m(3);
+	ASSERT_ANY_THROW(m.AppendDimension(TVector<int>(3)));
+}
+
+TEST(TColMatrix, buffer_grows_geometrically)
+{
+	TColMatrix<int> m(0);
+	int reallocs = 0, cap = m.GetCapacity();
+	for (int n = 0; n < 1000; n++)
+	{
+		m.AppendDimension();
+		if (m.GetCapacity() != cap)
+		{
+			reallocs++;
+			cap = m.GetCapacity();
+		}
+	}
+	EXPECT_LE(reallocs, 25);
+	EXPECT_GE(m.GetCapacity(), m.GetPackedSize());
+}
+
+TEST(TColMatrix, reserve_avoids_reallocation)
+{
+	TColMatrix<int> m(0);
+	m.Reserve(100);
+	const int *p = m.GetData();
+	for (int n = 0; n < 100; n++)
+		m.AppendDimension();
+	EXPECT_EQ(p, m.GetData());
+}
+
+TEST(TColMatrix, output_matches_tmatrix)
+{
+	TMatrix<int> m(3);
+	m[0][2] = 4;
+	m[1][1] = 2;
+	ostringstream a, b;
+	a << m;
+	b << TColMatrix<int>(m);
+	EXPECT_EQ(a.str(), b.str());
+}
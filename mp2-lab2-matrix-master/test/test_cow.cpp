@@ -0,0 +1,300 @@
+#include "utview.h"
+
+#include <gtest.h>
+#include <thread>
+#include <vector>
+
+// Верхнетреугольная матрица 4 x 4 с элементами (i, j) = i + 2 * j
+static TMatrix<int> MakeCowMatrix()
+{
+	TMatrix<int> m(4);
+	for (int i = 0; i < 4; i++)
+		for (int j = i; j < 4; j++)
+			m[i][j] = i + 2 * j;
+	return m;
+}
+
+// Запись write в копию не меняет оригинал, запись в оригинал - копию;
+// проверяется и без UTMATRIX_COW (копии глубокие), и с ним
+template <class F>
+void ExpectMatrixCopiesIndependent(F write)
+{
+	TMatrix<int> m = MakeCowMatrix(), c(m);
+	write(c);
+	EXPECT_EQ(MakeCowMatrix(), m);
+	EXPECT_NE(MakeCowMatrix(), c);
+	TMatrix<int> d(1);
+	d = m;
+	write(m);
+	EXPECT_EQ(MakeCowMatrix(), d);
+}
+
+TEST(TCopyOnWrite, matrix_copies_stay_independent_through_every_accessor)
+{
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { a[1][2] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { a.at_unchecked(1)[2] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { a.GetData()[3] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { *(a.end() - 1) = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { (*a.Rows().begin())[3] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { a *= 2; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { a += MakeCowMatrix(); });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { a.Axpy(1, MakeCowMatrix()); });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { Row(a, 2)[1] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { Column(a, 3)[0] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { Block(a, 0, 2, 2, 2)(1, 1) = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { Transpose(a)(3, 1) = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { Slice(a[0], 1, 3) *= 2; });
+}
+
+TEST(TCopyOnWrite, matrix_copies_stay_independent_through_base_class)
+{
+	typedef TVector<TVector<int> > TBase;
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { static_cast<TBase&>(a)[1][2] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { static_cast<TBase&>(a).at_unchecked(3)[3] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { static_cast<TBase&>(a).GetData()[0][0] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a) { (*static_cast<TBase&>(a).begin())[1] = -1; });
+	ExpectMatrixCopiesIndependent([](TMatrix<int> &a)
+	{
+		TMatrix<int> z(4);
+		for (int i = 0; i < 4; i++)
+			for (int j = i; j < 4; j++)
+				z[i][j] = 0;
+		static_cast<TBase&>(a) = z;
+	});
+	TMatrix<int> m = MakeCowMatrix();
+	const TMatrix<int> c(m);
+	TBase &b = m;
+	b[2][3] = -1;
+	EXPECT_EQ(MakeCowMatrix(), c);
+	EXPECT_EQ(-1, m[2][3]);
+	EXPECT_EQ(b.GetData(), m.Rows().begin()); // строки базового класса - строки матрицы
+	TBase v(b); // копия базовой части - отдельный вектор строк
+	v[0][0] = -2;
+	EXPECT_EQ(0, m[0][0]);
+}
+
+TEST(TCopyOnWrite, references_taken_before_copy_do_not_change_copy)
+{
+	TVector<int> v(3);
+	for (int i = 0; i < 3; i++)
+		v[i] = i;
+	int &x = v[0];
+	TVector<int>::iterator it = v.begin();
+	TVectorSlice<int> vs = Slice(v, 1, 3);
+	const TVector<int> w(v);
+	x = 10;
+	it[1] = 11;
+	vs[1] = 12;
+	EXPECT_EQ(0, w[0]);
+	EXPECT_EQ(1, w[1]);
+	EXPECT_EQ(2, w[2]);
+
+	TMatrix<int> a = MakeCowMatrix();
+	int &e = a[0][0];
+	TVector<int> &r = a[0];
+	TMatrix<int>::iterator ai = a.begin();
+	TVectorSlice<int> s = Row(a, 1);
+	TColumnView<int> c = Column(a, 3);
+	TBlockView<int> bl = Block(a, 0, 2, 2, 2);
+	const TMatrix<int> b(a);
+	e = -1;
+	r[1] = -1;
+	ai[2] = -1;
+	s[1] = -1;
+	c[2] = -1;
+	bl(1, 1) = -1;
+	EXPECT_EQ(MakeCowMatrix(), b);
+	EXPECT_NE(MakeCowMatrix(), a);
+}
+
+TEST(TCopyOnWrite, vector_copies_stay_independent_through_every_accessor)
+{
+	auto writes = { +[](TVector<int> &v) { v[1] = -1; },
+		+[](TVector<int> &v) { v.GetData()[0] = -1; },
+		+[](TVector<int> &v) { *v.begin() = -1; },
+		+[](TVector<int> &v) { v += v; },
+		+[](TVector<int> &v) { Slice(v, 1, 3) *= -1; } };
+	auto make = []
+	{
+		TVector<int> v(4);
+		for (int i = 0; i < 4; i++)
+			v[i] = i + 1;
+		return v;
+	};
+	for (auto write : writes)
+	{
+		TVector<int> v = make(), c(v), d(1);
+		write(c);
+		EXPECT_EQ(make(), v);
+		EXPECT_NE(make(), c);
+		d = v;
+		write(v);
+		EXPECT_EQ(make(), d);
+	}
+}
+
+#if UTMATRIX_COW
+
+// Ссылки на элементы filled уже выданы, поэтому копия глубокая; у копии
+// новый буфер, который разделяется
+template <class T>
+T Shareable(const T &filled)
+{
+	return T(filled);
+}
+
+TEST(TCopyOnWrite, vector_copy_shares_buffer)
+{
+	TVector<int> f(5);
+	f[2] = 7;
+	ResetCowStats();
+	TVector<int> v = Shareable(f);
+	const TVector<int> c(v);
+	const TVector<int> &cv = v;
+	EXPECT_EQ(cv.GetData(), c.GetData());
+	EXPECT_EQ(7, c[2]);
+	EXPECT_EQ(1, GetCowStats().Shared);
+	EXPECT_EQ(0, GetCowStats().Detached);
+}
+
+TEST(TCopyOnWrite, write_to_copy_does_not_change_original)
+{
+	TVector<int> f(5);
+	f[2] = 7;
+	ResetCowStats();
+	TVector<int> v = Shareable(f);
+	TVector<int> c(v);
+	c[2] = 1;
+	EXPECT_EQ(7, v[2]);
+	EXPECT_EQ(1, c[2]);
+	EXPECT_NE(v.GetData(), c.GetData());
+	EXPECT_EQ(1, GetCowStats().Detached);
+	EXPECT_EQ(0, GetCowStats().Avoided());
+}
+
+TEST(TCopyOnWrite, write_to_original_does_not_change_copy)
+{
+	TVector<int> v(5);
+	v[0] = 3;
+	TVector<int> c(5);
+	c = v;
+	v += v;
+	EXPECT_EQ(6, v[0]);
+	EXPECT_EQ(3, c[0]);
+}
+
+TEST(TCopyOnWrite, buffer_outlives_original)
+{
+	TVector<int> f(4, 1);
+	f[3] = 9;
+	TVector<int> *v = new TVector<int>(Shareable(f));
+	TVector<int> c(*v);
+	delete v;
+	EXPECT_EQ(9, c[3]);
+	EXPECT_EQ(1, c.GetStartIndex());
+}
+
+TEST(TCopyOnWrite, matrix_copy_shares_buffer)
+{
+	TMatrix<int> f(4);
+	f[1][2] = 5;
+	ResetCowStats();
+	TMatrix<int> m = Shareable(f);
+	const TMatrix<int> c(m);
+	const TMatrix<int> &cm = m;
+	EXPECT_EQ(cm.GetData(), c.GetData());
+	EXPECT_EQ(5, c[1][2]);
+	EXPECT_EQ(1, GetCowStats().Shared);
+}
+
+TEST(TCopyOnWrite, write_to_matrix_copy_does_not_change_original)
+{
+	TMatrix<int> f(4);
+	f[1][2] = 5;
+	ResetCowStats();
+	TMatrix<int> m = Shareable(f);
+	TMatrix<int> c(m), d(4);
+	d = m;
+	c[1][2] = 1;
+	d *= 2;
+	const TMatrix<int> &cm = m;
+	EXPECT_EQ(5, cm[1][2]);
+	EXPECT_EQ(1, c[1][2]);
+	EXPECT_EQ(10, d[1][2]);
+	EXPECT_EQ(2, GetCowStats().Shared);
+	EXPECT_EQ(2, GetCowStats().Detached);
+}
+
+TEST(TCopyOnWrite, solve_does_not_change_right_side)
+{
+	TMatrix<double> m(3);
+	for (int i = 0; i < 3; i++)
+		for (int j = i; j < 3; j++)
+			m[i][j] = (i == j) ? 2.0 : 1.0;
+	TVector<double> b(3);
+	b[0] = b[1] = b[2] = 4.0;
+	TVector<double> x = m.Solve(b);
+	EXPECT_EQ(4.0, b[0]);
+	EXPECT_EQ(2.0, x[2]);
+}
+
+TEST(TCopyOnWrite, copies_can_be_written_in_other_threads)
+{
+	const int n = 4, copies = 50;
+	TMatrix<int> f(8);
+	f[0][7] = 1;
+	ResetCowStats();
+	const TMatrix<int> m = Shareable(f);
+	vector<thread> t;
+	for (int k = 0; k < n; k++)
+		t.emplace_back([&m, k]
+		{
+			for (int r = 0; r < copies; r++)
+			{
+				TMatrix<int> c(m);
+				if (r % 2 == 0)
+					c[0][7] = k;
+			}
+		});
+	for (thread &x : t)
+		x.join();
+	EXPECT_EQ(1, m[0][7]);
+	EXPECT_EQ(n * copies, GetCowStats().Shared);
+	EXPECT_EQ(n * copies / 2, GetCowStats().Avoided());
+}
+
+TEST(TCopyOnWrite, buffer_is_not_shared_after_reference_is_given_out)
+{
+	TVector<int> f(3);
+	f[0] = 1;
+	ResetCowStats();
+	TVector<int> v = Shareable(f);
+	const TVector<int> a(v); // общий буфер
+	int &x = v[0];           // v получает собственный буфер, он не разделяется
+	const TVector<int> b(v);
+	x = 2;
+	EXPECT_EQ(1, a[0]);
+	EXPECT_EQ(1, b[0]);
+	EXPECT_EQ(1, GetCowStats().Shared);
+	EXPECT_EQ(1, GetCowStats().Detached);
+	v = a; // новый буфер снова разделяется
+	const TVector<int> c(v);
+	const TVector<int> &cv = v;
+	EXPECT_EQ(cv.GetData(), c.GetData());
+}
+
+#else
+
+TEST(TCopyOnWrite, copies_are_deep_without_cow)
+{
+	ResetCowStats();
+	TVector<int> v(5);
+	TMatrix<int> m(3);
+	const TVector<int> cv(v);
+	const TMatrix<int> cm(m);
+	EXPECT_NE(static_cast<const TVector<int>&>(v).GetData(), cv.GetData());
+	EXPECT_NE(static_cast<const TMatrix<int>&>(m).GetData(), cm.GetData());
+	EXPECT_EQ(0, GetCowStats().Shared);
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "utfixed.h"
+
+#include <gtest.h>
+#include "test_matrices.h"
+
+TEST(TFixedMatrix, matrix_stores_elements_inline)
+{
+	EXPECT_EQ(sizeof(double) * 10, sizeof(TMatrix<double, 4>));
+	EXPECT_EQ(6, (TMatrix<int, 3>::GetPackedSize()));
+	EXPECT_EQ(3, (TMatrix<int, 3>::GetRowOffset(1)));
+}
+
+TEST(TFixedMatrix, can_create_matrix_at_compile_time)
+{
+	constexpr TMatrix<int, 3> m{ 1, 2, 3, 4, 5, 6 };
+	static_assert(m(0, 2) == 3, "");
+	static_assert(m(1, 1) == 4, "");
+	static_assert(m(2, 2) == 6, "");
+	constexpr TMatrix<int, 3> z;
+	static_assert(z(0, 1) == 0, "");
+	EXPECT_EQ(5, m(1, 2));
+}
+
+TEST(TFixedMatrix, arithmetic_is_evaluated_at_compile_time)
+{
+	constexpr TMatrix<int, 2> a{ 1, 2, 3 }, b{ 2, 0, 1 };
+	constexpr TMatrix<int, 2> c = a * b, s = a + b * 2;
+	static_assert(c == TMatrix<int, 2>{ 2, 2, 3 }, "");
+	static_assert(s == TMatrix<int, 2>{ 5, 2, 5 }, "");
+	constexpr TMatrix<int, 2>::TVec y = a * TMatrix<int, 2>::TVec{ 1, 1 };
+	static_assert((y[0] == 3) && (y[1] == 3), "");
+	constexpr TMatrix<double, 2>::TVec x = TMatrix<double, 2>{ 2, 1, 4 }.Solve({ 4, 8 });
+	static_assert((x[0] == 1) && (x[1] == 2), "");
+	EXPECT_EQ(c, (TMatrix<int, 2>{ 2, 2, 3 }));
+}
+
+TEST(TFixedMatrix, row_access_has_same_indices_as_dynamic_matrix)
+{
+	constexpr TMatrix<int, 3> c{ 1, 2, 3, 4, 5, 6 };
+	static_assert(c[1][2] == 5, "");
+	TMatrix<int, 4> f;
+	TMatrix<int> m(4);
+	for (int i = 0; i < 4; i++)
+		for (int j = i; j < 4; j++)
+		{
+			f[i][j] = 10 * i + j; // тот же код для обеих матриц
+			m[i][j] = 10 * i + j;
+		}
+	EXPECT_EQ(m, f.ToMatrix());
+	EXPECT_EQ(&f(1, 3), &f[1][3]);
+	EXPECT_EQ(2, f[2].GetSize());
+	EXPECT_EQ(2, f[2].GetStartIndex());
+	const TMatrix<int, 4> &cf = f;
+	EXPECT_EQ(23, cf[2][3]);
+	EXPECT_TRUE((is_same<decltype(cf[2][3]), const int&>::value));
+}
+
+TEST(TFixedMatrix, throws_when_initializer_has_wrong_length)
+{
+	ASSERT_ANY_THROW((TMatrix<int, 2>{ 1, 2 }));
+}
+
+#if UTMATRIX_BOUNDS_CHECK
+TEST(TFixedMatrix, throws_when_access_below_diagonal_or_out_of_range)
+{
+	TMatrix<int, 3> m;
+	ASSERT_ANY_THROW(m(1, 0));
+	ASSERT_ANY_THROW(m(0, 3));
+	ASSERT_ANY_THROW(m(-1, 1));
+	ASSERT_ANY_THROW(m[1][0]);
+	ASSERT_ANY_THROW(m[0][3]);
+	ASSERT_ANY_THROW(m[3][3]);
+}
+#endif
+
+TEST(TFixedMatrix, conversion_to_and_from_dynamic_matrix_is_exact)
+{
+	TMatrix<int, 5> f(MakeTestMatrix<int>(5));
+	TMatrix<int> m = f.ToMatrix();
+	for (int i = 0; i < 5; i++)
+		for (int j = i; j < 5; j++)
+			EXPECT_EQ(f(i, j), m[i][j]);
+	EXPECT_EQ(f, (TMatrix<int, 5>(m)));
+	ASSERT_ANY_THROW((TMatrix<int, 4>(m)));
+}
+
+template <int N>
+void CheckFixedMatchesDynamic()
+{
+	TMatrix<int, N> a(MakeTestMatrix<int>(N)), b = a * a;
+	TMatrix<int> da = a.ToMatrix(), db = b.ToMatrix();
+	EXPECT_EQ(da * db, (a * b).ToMatrix());
+	EXPECT_EQ(da + db, (a + b).ToMatrix());
+	EXPECT_EQ(da - db, (a - b).ToMatrix());
+	EXPECT_EQ(da * 3, (a * 3).ToMatrix());
+	TMatrix<int, N> c = a;
+	c += b;
+	c -= a;
+	EXPECT_EQ(b, c);
+	typename TMatrix<int, N>::TVec v;
+	TVector<int> dv(N);
+	for (int i = 0; i < N; i++)
+		v[i] = dv[i] = i % 3 - 1;
+	typename TMatrix<int, N>::TVec y = a * v;
+	TVector<int> dy = da * dv;
+	for (int i = 0; i < N; i++)
+		EXPECT_EQ(dy[i], y[i]);
+}
+
+TEST(TFixedMatrix, operations_match_dynamic_matrix)
+{
+	CheckFixedMatchesDynamic<1>();
+	CheckFixedMatchesDynamic<3>();
+	CheckFixedMatchesDynamic<4>();
+	CheckFixedMatchesDynamic<8>();
+}
+
+TEST(TFixedMatrix, can_solve_system)
+{
+	TMatrix<double, 6> a(MakeTestMatrix<double>(6));
+	TMatrix<double, 6>::TVec x{ 1, 2, 3, -1, 0.5, 4 };
+	TMatrix<double, 6>::TVec y = a.Solve(a * x);
+	for (int i = 0; i < 6; i++)
+		EXPECT_NEAR(x[i], y[i], 1e-12);
+}
+
+TEST(TFixedMatrix, throws_when_solve_singular_system)
+{
+	TMatrix<double, 3> a(MakeTestMatrix<double>(3));
+	a(1, 1) = 0;
+	ASSERT_ANY_THROW(a.Solve(TMatrix<double, 3>::TVec{}));
+}
@@ -0,0 +1,127 @@
+#include "utio.h"
+
+#include <gtest.h>
+#include <cstdio>
+#include <sstream>
+
+TEST(TTextIO, can_write_and_read_vector_exactly)
+{
+	TVector<double> v(5), r(5);
+	v[0] = 0.1;
+	v[1] = -2.5;
+	v[2] = 1e-300;
+	v[3] = 1.0 / 3.0;
+	v[4] = 123456789.0;
+	stringstream s;
+	WriteText(s, v);
+	ReadText(s, r);
+	EXPECT_EQ(v, r);
+}
+
+TEST(TTextIO, write_error_of_stream_with_exceptions_is_thrown)
+{
+	TVector<int> v(3);
+	for (int i = 0; i < 3; i++)
+		v[i] = i;
+	struct TFailBuf : streambuf {} buf; // любая запись не удается
+	ostream s(&buf);
+	s.exceptions(ios::badbit);
+	ASSERT_ANY_THROW(WriteText(s, v));
+	ostream q(&buf);
+	ASSERT_ANY_THROW(WriteText(q, v));
+}
+
+TEST(TTextIO, compact_matrix_output_matches_stream_operator)
+{
+	TMatrix<int> m(3);
+	for (int i = 0; i < 3; i++)
+		for (int j = i; j < 3; j++)
+			m[i][j] = 10 * i + j;
+	stringstream a, b;
+	WriteText(a, m);
+	b << m;
+	EXPECT_EQ(b.str(), a.str());
+	TMatrix<int> r(3);
+	ReadText(b, r);
+	EXPECT_EQ(m, r);
+}
+
+TEST(TTextIO, can_write_and_read_full_square_matrix)
+{
+	TMatrix<int> m(3);
+	for (int i = 0; i < 3; i++)
+		for (int j = i; j < 3; j++)
+			m[i][j] = i + j + 1;
+	stringstream s;
+	WriteText(s, m, TEXT_FULL);
+	EXPECT_EQ("1 2 3 \n0 3 4 \n0 0 5 \n", s.str());
+	TMatrix<int> r(3);
+	ReadText(s, r, TEXT_FULL);
+	EXPECT_EQ(m, r);
+}
+
+TEST(TTextIO, throws_when_full_matrix_is_not_upper_triangular)
+{
+	string text = "1 2\n3 4\n";
+	TMatrix<int> r(2);
+	stringstream s(text);
+	ASSERT_ANY_THROW(ReadText(s, r, TEXT_FULL));
+	ASSERT_ANY_THROW(ReadText(text.data(), text.data() + text.size(), r, TEXT_FULL));
+}
+
+TEST(TTextIO, throws_on_bad_or_missing_numbers)
+{
+	TVector<int> v(3);
+	stringstream bad("1 x 3"), shortText("1 2");
+	ASSERT_ANY_THROW(ReadText(bad, v));
+	EXPECT_TRUE(bad.fail());
+	ASSERT_ANY_THROW(ReadText(shortText, v));
+	string text = "1 2.5 3";
+	ASSERT_ANY_THROW(ReadText(text.data(), text.data() + text.size(), v));
+}
+
+TEST(TTextIO, stream_reading_stops_after_last_number)
+{
+	TVector<int> v(3);
+	stringstream s("+1 2\n\t3 rest");
+	ReadText(s, v);
+	string rest;
+	s >> rest;
+	EXPECT_EQ(1, v[0]);
+	EXPECT_EQ(3, v[2]);
+	EXPECT_EQ("rest", rest);
+}
+
+TEST(TTextIO, parallel_parsing_matches_serial_one)
+{
+	const int n = 500;
+	TMatrix<double> m(n);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			m[i][j] = i * 0.75 - j;
+	stringstream s;
+	WriteText(s, m, TEXT_FULL);
+	string text = s.str();
+	ASSERT_GT(text.size(), TEXT_PARALLEL_BYTES);
+	int old = GetNumThreads();
+	SetNumThreads(4);
+	TMatrix<double> r(n);
+	ReadText(text.data(), text.data() + text.size(), r, TEXT_FULL);
+	string cut = text.substr(0, text.size() / 2);
+	ASSERT_ANY_THROW(ReadText(cut.data(), cut.data() + cut.size(), r, TEXT_FULL));
+	SetNumThreads(old);
+	EXPECT_EQ(m, r);
+}
+
+TEST(TTextIO, can_save_and_load_file)
+{
+	const char *name = "test_io_matrix.tmp";
+	TMatrix<float> m(20), r(20);
+	for (int i = 0; i < 20; i++)
+		for (int j = i; j < 20; j++)
+			m[i][j] = 0.1f * i - j;
+	SaveText(name, m);
+	LoadText(name, r);
+	EXPECT_EQ(m, r);
+	remove(name);
+}
@@ -0,0 +1,110 @@
+#include "utview.h"
+
+#include <gtest.h>
+#include <iterator>
+#include <numeric>
+#if __has_include(<execution>)
+#include <execution>
+#endif
+
+static_assert(is_same<iterator_traits<TVector<double>::iterator>::iterator_category,
+	random_access_iterator_tag>::value, "TVector iterator must be random access");
+
+TEST(TVectorIterator, iterates_over_all_elements)
+{
+	TVector<int> v(5, 3);
+	iota(v.begin(), v.end(), 1);
+	EXPECT_EQ(5, v.end() - v.begin());
+	EXPECT_EQ(1, v[3]);
+	EXPECT_EQ(5, v[7]);
+	int s = 0;
+	for (int x : v)
+		s += x;
+	EXPECT_EQ(15, s);
+}
+
+TEST(TVectorIterator, const_vector_has_const_iterators)
+{
+	TVector<int> v(4);
+	fill(v.begin(), v.end(), 2);
+	const TVector<int> &c = v;
+	EXPECT_EQ(8, accumulate(c.begin(), c.end(), 0));
+	EXPECT_EQ(c.begin(), c.cbegin());
+	EXPECT_TRUE((is_same<decltype(c.begin()), const int*>::value));
+}
+
+TEST(TVectorIterator, empty_vector_has_empty_range)
+{
+	TVector<int> v(0);
+	EXPECT_EQ(v.begin(), v.end());
+}
+
+TEST(TMatrixIterator, flat_iterator_visits_stored_elements_row_by_row)
+{
+	TMatrix<int> m(4);
+	iota(m.begin(), m.end(), 0);
+	EXPECT_EQ(m.GetPackedSize(), m.end() - m.begin());
+	EXPECT_EQ(0, m[0][0]);
+	EXPECT_EQ(3, m[0][3]);
+	EXPECT_EQ(4, m[1][1]);
+	EXPECT_EQ(9, m[3][3]);
+	for (int i = 0; i < 4; i++)
+		for (int j = i; j < 4; j++)
+			EXPECT_EQ(m[i][j], m.begin()[m.GetRowOffset(i) + j - i]);
+}
+
+TEST(TMatrixIterator, row_iterator_visits_rows)
+{
+	TMatrix<int> m(5);
+	int i = 0;
+	for (TVector<int> &row : m.Rows())
+	{
+		EXPECT_EQ(i, row.GetStartIndex());
+		EXPECT_EQ(5 - i, row.GetSize());
+		fill(row.begin(), row.end(), i++);
+	}
+	EXPECT_EQ(5, m.Rows().size());
+	EXPECT_EQ(3, m[3][4]);
+	const TMatrix<int> &c = m;
+	EXPECT_EQ(0 * 5 + 1 * 4 + 2 * 3 + 3 * 2 + 4 * 1,
+		accumulate(c.begin(), c.end(), 0));
+}
+
+TEST(TVectorSliceIterator, slice_iterates_over_its_elements)
+{
+	TVector<int> v(6);
+	iota(v.begin(), v.end(), 0);
+	TVectorSlice<int> s = Slice(v, 2, 5);
+	EXPECT_EQ(2 + 3 + 4, accumulate(s.begin(), s.end(), 0));
+}
+
+#if defined(__cpp_lib_execution) && (__cpp_lib_execution >= 201603)
+TEST(TVectorIterator, parallel_algorithms_match_serial)
+{
+	const int n = 100000;
+	TVector<double> v(n), p(n), s(n);
+	for (int i = 0; i < n; i++)
+		v[i] = (i % 100) * 0.5;
+	transform(execution::par_unseq, v.begin(), v.end(), p.begin(),
+		[](double x) { return 2 * x + 1; });
+	transform(v.begin(), v.end(), s.begin(), [](double x) { return 2 * x + 1; });
+	EXPECT_EQ(s, p);
+	EXPECT_EQ(accumulate(s.begin(), s.end(), 0.0), reduce(execution::par_unseq, s.begin(), s.end()));
+}
+
+TEST(TMatrixIterator, parallel_algorithms_over_elements_and_rows)
+{
+	TMatrix<double> m(300), r(300);
+	for_each(execution::par_unseq, m.begin(), m.end(), [](double &x) { x = 1; });
+	EXPECT_EQ(m.GetPackedSize(), reduce(execution::par_unseq, m.begin(), m.end()));
+	for_each(execution::par, m.Rows().begin(), m.Rows().end(), [](TVector<double> &row)
+	{
+		transform(row.begin(), row.end(), row.begin(),
+			[&](double x) { return x * row.GetStartIndex(); });
+	});
+	for (int i = 0; i < 300; i++)
+		for (int j = i; j < 300; j++)
+			r[i][j] = i;
+	EXPECT_EQ(r, m);
+}
+#endif
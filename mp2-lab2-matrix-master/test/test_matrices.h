@@ -0,0 +1,20 @@
+// Общие тестовые данные
+
+#ifndef __TEST_MATRICES_H__
+#define __TEST_MATRICES_H__
+
+#include "utmatrix.h"
+
+// Верхнетреугольная матрица n x n с ненулевой диагональю и целыми
+// элементами; shift дает другую матрицу того же вида
+template <class T>
+TMatrix<T> MakeTestMatrix(int n, int shift = 0)
+{
+	TMatrix<T> m(n);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			m[i][j] = T((i * 7 + j * 3 + shift) % 5 + (i == j ? 4 : -2));
+	return m;
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "utmatrix.h"
+
+#include <gtest.h>
+
+TEST(TThreadPool, runs_every_task_once)
+{
+	TThreadPool pool;
+	pool.Resize(4);
+	EXPECT_EQ(4, pool.GetSize());
+	vector<int> hits(100, 0);
+	function<void(int)> f = [&](int t) { hits[t]++; };
+	for (int r = 0; r < 20; r++)
+		pool.Run(100, f);
+	for (int t = 0; t < 100; t++)
+		EXPECT_EQ(20, hits[t]);
+}
+
+TEST(TThreadPool, rethrows_exception_from_task)
+{
+	TThreadPool pool;
+	pool.Resize(3);
+	function<void(int)> f = [](int t) { if (t == 5) throw "Error"; };
+	ASSERT_ANY_THROW(pool.Run(8, f));
+	int n = 0;
+	function<void(int)> g = [&](int) { n++; };
+	pool.Run(1, g);
+	EXPECT_EQ(1, n);
+}
+
+TEST(TThreadPool, parallel_range_splits_into_equal_aligned_parts)
+{
+	int old = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(3);
+	SetParallelCutoff(0);
+	mutex m;
+	vector<pair<int, int> > parts;
+	ParallelRange<double>(1000, [&](int k0, int k1)
+	{
+		lock_guard<mutex> g(m);
+		parts.push_back(make_pair(k0, k1));
+	});
+	sort(parts.begin(), parts.end());
+	ASSERT_EQ(3u, parts.size());
+	EXPECT_EQ(0, parts[0].first);
+	EXPECT_EQ(1000, parts[2].second);
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		EXPECT_EQ(0, parts[i].first % ParallelAlign<double>());
+		if (i > 0)
+		{
+			EXPECT_EQ(parts[i - 1].second, parts[i].first);
+		}
+	}
+	SetNumThreads(old);
+	SetParallelCutoff(cutoff);
+}
+
+TEST(TThreadPool, parallel_align_is_one_cache_line)
+{
+	EXPECT_EQ(16, ParallelAlign<float>());
+	EXPECT_EQ(8, ParallelAlign<double>());
+	EXPECT_EQ(1, (ParallelAlign<char[100]>()));
+}
+
+TEST(TThreadPool, parallel_matrix_sum_matches_serial_one)
+{
+	const int s = 300;
+	TMatrix<double> m(s), n(s);
+	for (int i = 0; i < s; i++)
+		for (int j = i; j < s; j++)
+		{
+			m[i][j] = i - 0.5 * j;
+			n[i][j] = i * j;
+		}
+	TMatrix<double> serial = m + n * 2.0, diff = m - n;
+	int old = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(4);
+	SetParallelCutoff(1000);
+	EXPECT_EQ(serial, TMatrix<double>(m + n * 2.0));
+	EXPECT_EQ(diff, TMatrix<double>(m - n));
+	SetNumThreads(old);
+	SetParallelCutoff(cutoff);
+}
+
+TEST(TThreadPool, parallel_matrix_product_matches_serial_one)
+{
+	const int s = 400;
+	TMatrix<double> m(s), n(s);
+	for (int i = 0; i < s; i++)
+		for (int j = i; j < s; j++)
+		{
+			m[i][j] = (i * 7 + j * 3) % 11 - 5;
+			n[i][j] = 0.5 * ((i * 5 + j) % 13 - 6);
+		}
+	TMatrix<double> serial = m * n;
+	int old = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(3);
+	SetParallelCutoff(1000);
+	EXPECT_EQ(serial, m * n); // блоки строк считаются независимо - результат тот же
+	SetNumThreads(old);
+	SetParallelCutoff(cutoff);
+}
+
+TEST(TThreadPool, nested_run_from_calling_thread_runs_serially)
+{
+	TThreadPool pool;
+	pool.Resize(2);
+	atomic<int> n(0);
+	function<void(int)> inner = [&](int) { n++; };
+	function<void(int)> outer = [&](int) { pool.Run(4, inner); };
+	pool.Run(8, outer); // часть выполняет и вызывающий поток
+	EXPECT_EQ(32, n);
+}
+
+TEST(TThreadPool, resize_waits_for_running_job)
+{
+	TThreadPool pool;
+	pool.Resize(4);
+	atomic<int> n(0);
+	function<void(int)> f = [&](int) { this_thread::sleep_for(chrono::milliseconds(1)); n++; };
+	thread t([&] { for (int r = 0; r < 20; r++) pool.Run(16, f); });
+	for (int r = 0; r < 20; r++)
+		pool.Resize(2 + r % 3);
+	t.join();
+	EXPECT_EQ(20 * 16, n);
+}
+
+TEST(TThreadPool, resize_from_task_throws)
+{
+	TThreadPool pool;
+	pool.Resize(2);
+	function<void(int)> f = [&](int) { pool.Resize(3); };
+	ASSERT_ANY_THROW(pool.Run(4, f));
+	EXPECT_EQ(2, pool.GetSize());
+}
@@ -0,0 +1,133 @@
+#include "utmatrix.h"
+
+#include <gtest.h>
+#include <thread>
+
+TEST(TBufferPool, size_classes_cover_request_with_small_overhead)
+{
+	size_t cap, prev = 0;
+	int prevClass = -1;
+	for (size_t bytes = 1; bytes < 100000; bytes += 7)
+	{
+		int c = TBufferPool::ClassOf(bytes, cap);
+		EXPECT_GE(cap, bytes);
+		EXPECT_EQ(cap, TBufferPool::CapOf(c));
+		if (bytes > POOL_MIN_CLASS)
+		{
+			EXPECT_LE(cap, bytes + bytes / 4);
+		}
+		EXPECT_GE(c, prevClass);
+		EXPECT_GE(cap, prev);
+		prevClass = c;
+		prev = cap;
+	}
+}
+
+TEST(TBufferPool, freed_buffer_is_reused_for_same_size)
+{
+	TrimBufferPool();
+	ResetBufferPoolStats();
+	double *p = AllocAligned<double>(1000);
+	FreeAligned(p, 1000);
+	EXPECT_EQ(1u, GetBufferPoolStats().RetainedBuffers);
+	double *q = AllocAligned<double>(990); // тот же класс
+	EXPECT_EQ(p, q);
+	EXPECT_EQ(0u, size_t(q) % POOL_ALIGNMENT);
+	TBufferPoolStats st = GetBufferPoolStats();
+	EXPECT_EQ(2u, st.Requests);
+	EXPECT_EQ(1u, st.Hits);
+	EXPECT_EQ(0u, st.RetainedBytes);
+	FreeAligned(q, 990);
+}
+
+TEST(TBufferPool, temporaries_in_loop_hit_pool)
+{
+	TVector<int> a(500), b(500), c(500);
+	for (int i = 0; i < 500; i++)
+	{
+		a[i] = i;
+		b[i] = 2 * i;
+	}
+	TrimBufferPool();
+	ResetBufferPoolStats();
+	for (int r = 0; r < 100; r++)
+	{
+		TVector<int> t(a + b);
+		c = t - a;
+	}
+	EXPECT_EQ(b, c);
+	EXPECT_GE(GetBufferPoolStats().HitRate(), 0.99);
+}
+
+TEST(TBufferPool, trim_releases_retained_bytes)
+{
+	TrimBufferPool();
+	{
+		TMatrix<double> m(100), n(50);
+		TVector<float> v(3000);
+	}
+	TBufferPoolStats st = GetBufferPoolStats();
+	EXPECT_EQ(3u, st.RetainedBuffers);
+	EXPECT_GE(st.RetainedBytes, (5050 + 1275) * sizeof(double) + 3000 * sizeof(float));
+	TrimBufferPool(st.RetainedBytes - 1);
+	EXPECT_EQ(2u, GetBufferPoolStats().RetainedBuffers);
+	TrimBufferPool();
+	EXPECT_EQ(0u, GetBufferPoolStats().RetainedBytes);
+	EXPECT_EQ(0u, GetBufferPoolStats().RetainedBuffers);
+}
+
+TEST(TBufferPool, zero_limit_disables_retention)
+{
+	size_t old = GetBufferPoolLimit();
+	SetBufferPoolLimit(0);
+	{
+		TVector<int> v(100);
+	}
+	EXPECT_EQ(0u, GetBufferPoolStats().RetainedBytes);
+	SetBufferPoolLimit(old);
+}
+
+TEST(TBufferPool, pools_of_threads_are_separate)
+{
+	TrimBufferPool();
+	{
+		TVector<double> v(1000);
+	}
+	size_t other = 1;
+	thread t([&]
+	{
+		other = GetBufferPoolStats().RetainedBuffers;
+		TVector<double> w(1000);
+	});
+	t.join();
+	EXPECT_EQ(0u, other);
+	EXPECT_EQ(1u, GetBufferPoolStats().RetainedBuffers);
+	TrimBufferPool();
+}
+
+TEST(TBufferPool, buffer_allocated_at_thread_exit_has_full_class_size)
+{
+	struct TExitAlloc
+	{
+		void **Out;
+		~TExitAlloc() { *Out = PoolAlloc(100, POOL_ALIGNMENT); } // пул потока уже уничтожен
+	};
+	void *p = nullptr;
+	thread t([&]
+	{
+		thread_local TExitAlloc a{ &p };
+		(void)a;
+		GetBufferPoolStats(); // пул создается после a и уничтожается раньше
+	});
+	t.join();
+	ASSERT_TRUE(p != nullptr);
+	TrimBufferPool();
+	PoolFree(p, 100, POOL_ALIGNMENT);
+	size_t cap;
+	TBufferPool::ClassOf(100, cap);
+	void *q = PoolAlloc(cap, POOL_ALIGNMENT);
+	EXPECT_EQ(p, q);
+	fill_n(static_cast<char*>(q), cap, 0); // весь класс доступен
+	PoolFree(q, cap, POOL_ALIGNMENT);
+	TrimBufferPool();
+}
@@ -0,0 +1,136 @@
+#include "utreduce.h"
+
+#include <gtest.h>
+#include <cstring>
+
+// Значения с разными порядками величины: сумма чувствительна к порядку сложения
+static TVector<double> MakeReduceVector(int n)
+{
+	TVector<double> v(n);
+	for (int i = 0; i < n; i++)
+		v[i] = ((i % 1000) * 7919 % 1000 - 500) * ((i % 3 == 0) ? 1e-7 : 1.3);
+	return v;
+}
+
+static TMatrix<double> MakeReduceMatrix(int n)
+{
+	TMatrix<double> m(n);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			m[i][j] = ((i * 31 + j * 17) % 101 - 50) * ((j % 5 == 0) ? 1e-6 : 0.7);
+	return m;
+}
+
+static bool SameBits(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+TEST(Reduce, can_sum_vector)
+{
+	TVector<int> v(5);
+	for (int i = 0; i < 5; i++)
+		v[i] = i - 1;
+	EXPECT_EQ(5, Sum(v));
+}
+
+TEST(Reduce, sum_of_empty_vector_is_zero)
+{
+	EXPECT_EQ(0, Sum(TVector<int>(0)));
+}
+
+TEST(Reduce, can_compute_vector_norms)
+{
+	TVector<double> v(3);
+	v[0] = 3;
+	v[1] = -4;
+	v[2] = 0;
+	EXPECT_DOUBLE_EQ(7, Norm1(v));
+	EXPECT_DOUBLE_EQ(5, Norm2(v));
+	EXPECT_DOUBLE_EQ(4, NormInf(v));
+	EXPECT_DOUBLE_EQ(4, MaxAbs(v));
+}
+
+TEST(Reduce, norm2_of_int_vector_is_floating_point)
+{
+	TVector<int> v(2);
+	v[0] = 1;
+	v[1] = 1;
+	EXPECT_DOUBLE_EQ(sqrt(2.0), Norm2(v));
+}
+
+TEST(Reduce, long_sum_is_accurate)
+{
+	TVector<double> v(1000000);
+	for (int i = 0; i < v.GetSize(); i++)
+		v[i] = 0.1;
+	EXPECT_NEAR(100000.0, Sum(v), 1e-8);
+}
+
+TEST(Reduce, can_compute_matrix_reductions)
+{
+	TMatrix<int> m(3); // 1 -2  3
+	m[0][0] = 1;       //    4 -5
+	m[0][1] = -2;      //       6
+	m[0][2] = 3;
+	m[1][1] = 4;
+	m[1][2] = -5;
+	m[2][2] = 6;
+	EXPECT_EQ(7, Sum(m));
+	EXPECT_EQ(11, Trace(m));
+	EXPECT_EQ(6, MaxAbs(m));
+	EXPECT_EQ(14, Norm1(m));   // столбец 2: 3 + 5 + 6
+	EXPECT_EQ(9, NormInf(m));  // строка 1: 4 + 5
+	EXPECT_DOUBLE_EQ(sqrt(91.0), NormFrobenius(m));
+}
+
+TEST(Reduce, matrix_norms_match_direct_computation)
+{
+	int n = 300;
+	TMatrix<double> m = MakeReduceMatrix(n);
+	double fro = 0, n1 = 0, ninf = 0;
+	for (int i = 0; i < n; i++)
+	{
+		double r = 0;
+		for (int j = i; j < n; j++)
+		{
+			fro += m[i][j] * m[i][j];
+			r += fabs(m[i][j]);
+		}
+		ninf = max(ninf, r);
+	}
+	for (int j = 0; j < n; j++)
+	{
+		double c = 0;
+		for (int i = 0; i <= j; i++)
+			c += fabs(m[i][j]);
+		n1 = max(n1, c);
+	}
+	EXPECT_NEAR(sqrt(fro), NormFrobenius(m), 1e-9);
+	EXPECT_NEAR(n1, Norm1(m), 1e-9);
+	EXPECT_NEAR(ninf, NormInf(m), 1e-9);
+}
+
+TEST(Reduce, results_do_not_depend_on_thread_count)
+{
+	TVector<double> v = MakeReduceVector(300001);
+	TMatrix<double> m = MakeReduceMatrix(700);
+	int threads = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(1);
+	double s = Sum(v), n2 = Norm2(v), ms = Sum(m), fro = NormFrobenius(m),
+		n1 = Norm1(m), ninf = NormInf(m), tr = Trace(m);
+	SetParallelCutoff(0);
+	for (int t : { 2, 3, 4, 7 })
+	{
+		SetNumThreads(t);
+		EXPECT_TRUE(SameBits(s, Sum(v)));
+		EXPECT_TRUE(SameBits(n2, Norm2(v)));
+		EXPECT_TRUE(SameBits(ms, Sum(m)));
+		EXPECT_TRUE(SameBits(fro, NormFrobenius(m)));
+		EXPECT_TRUE(SameBits(n1, Norm1(m)));
+		EXPECT_TRUE(SameBits(ninf, NormInf(m)));
+		EXPECT_TRUE(SameBits(tr, Trace(m)));
+	}
+	SetNumThreads(threads);
+	SetParallelCutoff(cutoff);
+}
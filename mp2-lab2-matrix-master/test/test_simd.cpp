@@ -0,0 +1,146 @@
+#include "utmatrix.h"
+
+#include <gtest.h>
+
+// Результаты ядер каждого доступного уровня сравниваются со скалярными
+template <class T>
+void CheckKernels(TSimdLevel level)
+{
+	const TSimdKernels<T> k = MakeSimdKernels<T>(level);
+	for (int n = 0; n < 70; n++)
+	{
+		T *a = new T[n + 1], *b = new T[n + 1], *d = new T[n + 1], *e = new T[n + 1];
+		for (int i = 0; i < n; i++)
+		{
+			a[i] = T(i % 7 + 1);
+			b[i] = T(3 - i % 5);
+		}
+		k.Add(d, a, b, n);
+		ScalarBinary<T, SIMD_OP_ADD>(e, a, b, n);
+		for (int i = 0; i < n; i++)
+			ASSERT_EQ(e[i], d[i]);
+		k.Sub(d, a, b, n);
+		ScalarBinary<T, SIMD_OP_SUB>(e, a, b, n);
+		for (int i = 0; i < n; i++)
+			ASSERT_EQ(e[i], d[i]);
+		k.MulScalar(d, a, T(3), n);
+		ScalarWithScalar<T, SIMD_OP_MUL>(e, a, T(3), n);
+		for (int i = 0; i < n; i++)
+			ASSERT_EQ(e[i], d[i]);
+		k.SubScalar(d, a, T(2), n);
+		ScalarWithScalar<T, SIMD_OP_SUB>(e, a, T(2), n);
+		for (int i = 0; i < n; i++)
+			ASSERT_EQ(e[i], d[i]);
+		EXPECT_EQ(ScalarDot(a, b, n), k.Dot(a, b, n));
+		copy_n(b, n, d);
+		copy_n(b, n, e);
+		k.Axpy(d, T(2), a, n);
+		ScalarAxpy(e, T(2), a, n);
+		for (int i = 0; i < n; i++)
+			ASSERT_EQ(e[i], d[i]);
+		delete[] a;
+		delete[] b;
+		delete[] d;
+		delete[] e;
+	}
+	ASSERT_LE(k.MR * k.NR, SIMD_MICRO_MAX);
+	for (int n : { 0, 1, 7, 64 }) // микроядро умножения: n шагов по k
+	{
+		T *ap = new T[n * k.MR + 1], *bp = new T[n * k.NR + 1];
+		T d[SIMD_MICRO_MAX], e[SIMD_MICRO_MAX];
+		for (int i = 0; i < n * k.MR; i++)
+			ap[i] = T(i % 7 - 3);
+		for (int i = 0; i < n * k.NR; i++)
+			bp[i] = T(i % 5 - 2);
+		k.MulMicro(ap, bp, n, d);
+		for (int i = 0; i < k.MR; i++)
+			for (int j = 0; j < k.NR; j++)
+			{
+				e[i * k.NR + j] = T(0);
+				for (int p = 0; p < n; p++)
+					e[i * k.NR + j] = e[i * k.NR + j] + ap[p * k.MR + i] * bp[p * k.NR + j];
+			}
+		for (int i = 0; i < k.MR * k.NR; i++)
+			ASSERT_EQ(e[i], d[i]);
+		delete[] ap;
+		delete[] bp;
+	}
+}
+
+TEST(TSimd, kernels_of_every_level_match_scalar_ones)
+{
+	for (int l = SIMD_SCALAR; l <= DetectSimdLevel(); l++)
+	{
+		CheckKernels<float>(TSimdLevel(l));
+		CheckKernels<double>(TSimdLevel(l));
+		CheckKernels<int32_t>(TSimdLevel(l));
+		CheckKernels<int64_t>(TSimdLevel(l));
+	}
+}
+
+TEST(TSimd, matrix_product_does_not_depend_on_level)
+{
+	const int s = 150;
+	TMatrix<double> m(s), n(s);
+	for (int i = 0; i < s; i++)
+		for (int j = i; j < s; j++)
+		{
+			m[i][j] = (i * 7 + j * 3) % 11 - 5;
+			n[i][j] = (i * 5 + j) % 13 - 6;
+		}
+	TSimdLevel old = GetSimdLevel();
+	SetSimdLevel(SIMD_SCALAR);
+	TMatrix<double> p = m * n;
+	for (int l = SIMD_SSE2; l <= DetectSimdLevel(); l++)
+	{
+		SetSimdLevel(TSimdLevel(l));
+		EXPECT_EQ(p, m * n); // целые значения - точно при любом порядке сложений
+	}
+	SetSimdLevel(old);
+}
+
+TEST(TSimd, cant_set_level_above_detected)
+{
+	TSimdLevel old = GetSimdLevel();
+	EXPECT_EQ(DetectSimdLevel(), SetSimdLevel(SIMD_AVX512));
+	EXPECT_EQ(SIMD_SCALAR, SetSimdLevel(SIMD_SCALAR));
+	SetSimdLevel(old);
+}
+
+TEST(TSimd, vector_operations_do_not_depend_on_level)
+{
+	TVector<double> a(37), b(37);
+	for (int i = 0; i < 37; i++)
+	{
+		a[i] = i * 0.5;
+		b[i] = 2.0 - i;
+	}
+	TSimdLevel old = GetSimdLevel();
+	SetSimdLevel(SIMD_SCALAR);
+	TVector<double> s = a + b, d = a - b, m = a * 4.0;
+	double dot = a * b;
+	for (int l = SIMD_SSE2; l <= DetectSimdLevel(); l++)
+	{
+		SetSimdLevel(TSimdLevel(l));
+		EXPECT_EQ(s, a + b);
+		EXPECT_EQ(d, a - b);
+		EXPECT_EQ(m, a * 4.0);
+		EXPECT_DOUBLE_EQ(dot, a * b);
+	}
+	SetSimdLevel(old);
+}
+
+TEST(TSimd, matrix_operations_use_kernels_on_packed_buffer)
+{
+	TMatrix<int> m(9), n(9);
+	for (int i = 0; i < 9; i++)
+		for (int j = i; j < 9; j++)
+		{
+			m[i][j] = i + j;
+			n[i][j] = i * j;
+		}
+	TMatrix<int> s = m + n;
+	for (int i = 0; i < 9; i++)
+		for (int j = i; j < 9; j++)
+			EXPECT_EQ(i + j + i * j, s[i][j]);
+}
@@ -0,0 +1,276 @@
+#include "utview.h"
+
+#include <gtest.h>
+
+// Верхнетреугольная матрица с целыми элементами: (i, j) = 10 * i + j
+TMatrix<int> MakeSliceTestMatrix(int n)
+{
+	TMatrix<int> m(n);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			m[i][j] = 10 * i + j;
+	return m;
+}
+
+TEST(TVectorSlice, slice_refers_to_vector_elements)
+{
+	TVector<int> v(6, 2);
+	for (int i = 2; i < 8; i++)
+		v[i] = i;
+	TVectorSlice<int> s = Slice(v, 3, 6);
+	EXPECT_EQ(3, s.GetSize());
+	EXPECT_EQ(3, s[0]);
+	EXPECT_EQ(5, s[2]);
+	s[1] = 40;
+	EXPECT_EQ(40, v[4]);
+}
+
+TEST(TVectorSlice, throws_when_slice_is_out_of_range)
+{
+	TVector<int> v(6, 2);
+	ASSERT_ANY_THROW(Slice(v, 1, 4));
+	ASSERT_ANY_THROW(Slice(v, 5, 9));
+	ASSERT_ANY_THROW(Slice(v, 5, 4));
+	ASSERT_NO_THROW(Slice(v, 8, 8));
+}
+
+#if UTMATRIX_BOUNDS_CHECK
+TEST(TVectorSlice, throws_when_index_is_out_of_range)
+{
+	TVector<int> v(5);
+	TVectorSlice<int> s = Slice(v, 1, 3);
+	ASSERT_ANY_THROW(s[2]);
+	ASSERT_ANY_THROW(s[-1]);
+}
+#endif
+
+TEST(TVectorSlice, can_assign_and_evaluate_expressions)
+{
+	TVector<int> v(8), a(3), b(3);
+	fill(v.begin(), v.end(), 0);
+	for (int i = 0; i < 3; i++)
+	{
+		a[i] = i + 1;
+		b[i] = 10 * (i + 1);
+	}
+	TVectorSlice<int> s = Slice(v, 2, 5);
+	s = a;
+	EXPECT_EQ(2, v[3]);
+	s = a + b * 2;
+	EXPECT_EQ(21, v[2]);
+	EXPECT_EQ(63, v[4]);
+	s -= a;
+	s += Slice(b);
+	s *= 2;
+	EXPECT_EQ(120, v[3]);
+	s.Axpy(-1, b);
+	EXPECT_EQ(100, v[3]);
+	EXPECT_EQ(0, v[1]);
+	EXPECT_EQ(0, v[5]);
+	ASSERT_ANY_THROW(s = Slice(v, 0, 2));
+}
+
+TEST(TVectorSlice, slice_takes_part_in_expressions_and_reductions)
+{
+	TVector<int> v(10);
+	for (int i = 0; i < 10; i++)
+		v[i] = i - 4;
+	TVectorSlice<int> s = Slice(v, 2, 7), t = Slice(v, 5, 10);
+	TVector<int> r = s + t;
+	EXPECT_EQ(-2 + 1, r[0]);
+	EXPECT_EQ(s * t, -2 * 1 + -1 * 2 + 0 * 3 + 1 * 4 + 2 * 5);
+	EXPECT_EQ(0, Sum(s));
+	EXPECT_EQ(6, Norm1(s));
+	EXPECT_EQ(2, MaxAbs(s));
+	EXPECT_EQ(Sum(s) + Sum(t), Sum(s + t));
+}
+
+TEST(TVectorSlice, large_slice_reduction_matches_vector)
+{
+	const int n = 3 * REDUCE_BLOCK + 17;
+	TVector<double> v(n + 20), w(n);
+	for (int i = 0; i < n + 20; i++)
+		v[i] = (i % 100) * 0.25 - 12;
+	for (int i = 0; i < n; i++)
+		w[i] = v[i + 10];
+	EXPECT_EQ(Sum(w), Sum(Slice(v, 10, n + 10)));
+	EXPECT_EQ(Norm2(w), Norm2(Slice(v, 10, n + 10)));
+}
+
+TEST(TVectorSlice, row_of_matrix_refers_to_stored_elements)
+{
+	TMatrix<int> m = MakeSliceTestMatrix(5);
+	TVectorSlice<int> r = Row(m, 2);
+	EXPECT_EQ(3, r.GetSize());
+	EXPECT_EQ(22, r[0]);
+	EXPECT_EQ(24, r[2]);
+	r *= 2;
+	EXPECT_EQ(46, m[2][3]);
+	EXPECT_EQ(13, m[1][3]);
+	ASSERT_ANY_THROW(Row(m, 5));
+}
+
+TEST(TColumnView, column_refers_to_matrix_elements)
+{
+	TMatrix<int> m = MakeSliceTestMatrix(5);
+	TColumnView<int> c = Column(m, 3);
+	EXPECT_EQ(4, c.GetSize());
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(10 * i + 3, c[i]);
+	c[1] = -1;
+	EXPECT_EQ(-1, m[1][3]);
+	ASSERT_ANY_THROW(Column(m, 5));
+}
+
+TEST(TColumnView, can_evaluate_expressions_and_reductions_on_column)
+{
+	TMatrix<int> m = MakeSliceTestMatrix(6);
+	TColumnView<int> c = Column(m, 4);
+	TVector<int> v(5);
+	for (int i = 0; i < 5; i++)
+		v[i] = 1;
+	c += v;
+	c *= 2;
+	for (int i = 0; i < 5; i++)
+		EXPECT_EQ(2 * (10 * i + 4 + 1), m[i][4]);
+	EXPECT_EQ(2 * (0 + 10 + 20 + 30 + 40 + 5 * 5), Sum(c));
+	EXPECT_EQ(v * c, Sum(c));
+	TMatrix<int> r = MakeSliceTestMatrix(6);
+	Column(m, 2) = Slice(Row(r, 1), 2, 5); // элементы (1, 3..5)
+	EXPECT_EQ(14, m[1][2]);
+	EXPECT_EQ(15, m[2][2]);
+}
+
+TEST(TBlockView, dense_block_refers_to_matrix_elements)
+{
+	TMatrix<int> m = MakeSliceTestMatrix(8);
+	TBlockView<int> b = Block(m, 1, 4, 3, 4);
+	EXPECT_FALSE(b.IsTriangular());
+	EXPECT_EQ(14, b(0, 0));
+	EXPECT_EQ(37, b(2, 3));
+	EXPECT_EQ(4, b.Row(1).GetSize());
+	b(1, 2) = 0;
+	EXPECT_EQ(0, m[2][6]);
+}
+
+TEST(TBlockView, throws_when_block_crosses_diagonal)
+{
+	TMatrix<int> m(8);
+	ASSERT_ANY_THROW(Block(m, 2, 3, 3, 2));
+	ASSERT_ANY_THROW(Block(m, 2, 2, 3, 2));
+	ASSERT_ANY_THROW(Block(m, 5, 6, 2, 3));
+	ASSERT_NO_THROW(Block(m, 2, 4, 3, 4));
+}
+
+TEST(TBlockView, diagonal_block_is_triangular)
+{
+	TMatrix<int> m = MakeSliceTestMatrix(8);
+	TBlockView<int> d = Block(m, 3, 3, 4, 4);
+	EXPECT_TRUE(d.IsTriangular());
+	EXPECT_EQ(33, d(0, 0));
+	EXPECT_EQ(66, d(3, 3));
+	EXPECT_EQ(1, d.Row(3).GetSize());
+	d *= 0;
+	EXPECT_EQ(0, m[4][5]);
+	EXPECT_EQ(37, m[3][7]);
+}
+
+TEST(TBlockView, block_arithmetic_updates_matrix_in_place)
+{
+	TMatrix<int> m = MakeSliceTestMatrix(8), r = m;
+	TBlockView<int> a = Block(m, 0, 4, 4, 4), b = Block(m, 0, 0, 4, 4);
+	ASSERT_ANY_THROW(a += b);
+	a += Block(r, 0, 4, 4, 4);
+	a.Axpy(-3, Block(r, 0, 4, 4, 4));
+	for (int i = 0; i < 4; i++)
+		for (int j = 4; j < 8; j++)
+			EXPECT_EQ(-r[i][j], m[i][j]);
+	a = Block(r, 0, 4, 4, 4);
+	EXPECT_EQ(r, m);
+	EXPECT_EQ(Block(r, 4, 4, 4, 4), Block(m, 4, 4, 4, 4));
+}
+
+TEST(TBlockView, block_times_vector_matches_matrix_product)
+{
+	TMatrix<int> m = MakeSliceTestMatrix(8);
+	TVector<int> x(8), y(8);
+	for (int i = 0; i < 8; i++)
+	{
+		x[i] = i % 3 - 1;
+		y[i] = 0;
+	}
+	// y = U x по блокам 2 x 2: диагональные блоки и блок над диагональю
+	Block(m, 0, 0, 4, 4).MulAdd(Slice(x, 0, 4), Slice(y, 0, 4));
+	Block(m, 0, 4, 4, 4).MulAdd(Slice(x, 4, 8), Slice(y, 0, 4));
+	Block(m, 4, 4, 4, 4).MulAdd(Slice(x, 4, 8), Slice(y, 4, 8));
+	EXPECT_EQ(m * x, y);
+}
+
+TEST(TBlockView, block_reductions_match_elements)
+{
+	TMatrix<double> m(10);
+	for (int i = 0; i < 10; i++)
+		for (int j = i; j < 10; j++)
+			m[i][j] = i - j + 0.5;
+	TBlockView<double> d = Block(m, 2, 2, 5, 5);
+	double s = 0, a = 0, f = 0;
+	for (int i = 2; i < 7; i++)
+		for (int j = i; j < 7; j++)
+		{
+			s += m[i][j];
+			a = max(a, fabs(m[i][j]));
+			f += m[i][j] * m[i][j];
+		}
+	EXPECT_DOUBLE_EQ(s, Sum(d));
+	EXPECT_DOUBLE_EQ(a, MaxAbs(d));
+	EXPECT_DOUBLE_EQ(sqrt(f), NormFrobenius(d));
+	EXPECT_DOUBLE_EQ(NormFrobenius(m), NormFrobenius(Block(m, 0, 0, 10, 10)));
+}
+
+TEST(TVectorSlice, views_of_const_data_are_read_only)
+{
+	const TVector<int> v(4);
+	const TMatrix<int> m = MakeSliceTestMatrix(5);
+	EXPECT_TRUE((is_same<decltype(Slice(v, 0, 4)), TVectorSlice<const int> >::value));
+	EXPECT_TRUE((is_same<decltype(Slice(v)), TVectorSlice<const int> >::value));
+	EXPECT_TRUE((is_same<decltype(Row(m, 0)), TVectorSlice<const int> >::value));
+	EXPECT_TRUE((is_same<decltype(Column(m, 0)), TColumnView<const int> >::value));
+	EXPECT_TRUE((is_same<decltype(Block(m, 0, 0, 2, 2)), TBlockView<const int> >::value));
+	EXPECT_FALSE((is_convertible<TVectorSlice<const int>, TVectorSlice<int> >::value));
+	EXPECT_FALSE((is_convertible<TColumnView<const int>, TColumnView<int> >::value));
+	EXPECT_FALSE((is_convertible<TBlockView<const int>, TBlockView<int> >::value));
+	TVector<int> u(4);
+	const TVectorSlice<int> s = Slice(u);
+	EXPECT_TRUE((is_same<decltype(Slice(s, 0, 2)), TVectorSlice<const int> >::value));
+	EXPECT_TRUE((is_same<decltype(s[0]), const int&>::value));
+	EXPECT_TRUE((is_same<decltype(Block(m, 0, 0, 2, 2).Row(0)[0]), const int&>::value));
+	EXPECT_TRUE((is_same<decltype(Block(m, 0, 0, 2, 2)(0, 0)), const int&>::value));
+}
+
+TEST(TVectorSlice, views_of_const_data_read_elements_in_place)
+{
+	const TMatrix<int> m = MakeSliceTestMatrix(6);
+	TVectorSlice<const int> r = Row(m, 2);
+	EXPECT_EQ(&m[2][2], &r[0]);
+	EXPECT_EQ(24, Slice(r, 1, 3)[1]);
+	TColumnView<const int> c = Column(m, 4);
+	EXPECT_EQ(&m[3][4], &c[3]);
+	TBlockView<const int> b = Block(m, 0, 3, 3, 3);
+	EXPECT_EQ(&m[1][4], &b(1, 1));
+	EXPECT_EQ(Sum(Row(m, 2)), Sum(Slice(m[2])));
+	TMatrix<int> w(6);
+	Row(w, 2) = r;                                  // чтение через представления
+	Column(w, 5) = Column(m, 5);
+	Block(w, 0, 3, 3, 3) = b;
+	EXPECT_EQ(m[2][3], w[2][3]);
+	EXPECT_EQ(m[4][5], w[4][5]);
+	EXPECT_EQ(m[1][4], w[1][4]);
+	TBlockView<const int> rw = Block(w, 0, 3, 3, 3); // изменяемое -> только чтение
+	EXPECT_TRUE(rw == b);
+	TVector<int> x(6), y(3);
+	for (int i = 0; i < 6; i++)
+		x[i] = i - 2;
+	fill(y.begin(), y.end(), 0);
+	b.MulAdd(Slice(x, 3, 6), Slice(y));
+	EXPECT_EQ(Row(m, 1) * Slice(x, 1, 6) - Slice(Row(m, 1), 0, 2) * Slice(x, 1, 3), y[1]);
+}
@@ -0,0 +1,181 @@
+#include "uttiled.h"
+
+#include <gtest.h>
+#include "test_matrices.h"
+
+TEST(TTiledMatrix, can_create_tiled_matrix)
+{
+	ASSERT_NO_THROW(TTiledMatrix<int> m(5, 2));
+}
+
+TEST(TTiledMatrix, throws_when_create_with_negative_size_or_bad_tile)
+{
+	ASSERT_ANY_THROW(TTiledMatrix<int> m(-1));
+	ASSERT_ANY_THROW(TTiledMatrix<int> m(5, 0));
+}
+
+TEST(TTiledMatrix, new_matrix_is_zero)
+{
+	TTiledMatrix<int> m(7, 3);
+	for (int i = 0; i < 7; i++)
+		for (int j = i; j < 7; j++)
+			EXPECT_EQ(0, m(i, j));
+}
+
+TEST(TTiledMatrix, can_set_and_get_element)
+{
+	TTiledMatrix<int> m(7, 3);
+	m(1, 5) = 4;
+	m(4, 4) = 2;
+	EXPECT_EQ(4, m(1, 5));
+	EXPECT_EQ(2, m(4, 4));
+	EXPECT_EQ(0, m(1, 4));
+}
+
+#if UTMATRIX_BOUNDS_CHECK
+TEST(TTiledMatrix, throws_when_access_below_diagonal_or_out_of_range)
+{
+	TTiledMatrix<int> m(4, 2);
+	ASSERT_ANY_THROW(m(2, 1));
+	ASSERT_ANY_THROW(m(0, 4));
+	ASSERT_ANY_THROW(m(-1, 0));
+}
+#endif
+
+TEST(TTiledMatrix, tiles_are_stored_in_morton_order)
+{
+	TTiledMatrix<int> m(8, 2, TILE_MORTON); // 4 x 4 плитки
+	const int d = 3, f = 4;                 // размеры диагональной и плотной плиток
+	EXPECT_EQ(0, m.GetTileOffset(0, 0));
+	EXPECT_EQ(d, m.GetTileOffset(0, 1));
+	EXPECT_EQ(d + f, m.GetTileOffset(1, 1));
+	EXPECT_EQ(2 * d + f, m.GetTileOffset(0, 2));
+	EXPECT_EQ(4 * d + 6 * f, m.GetStoredSize());
+}
+
+TEST(TTiledMatrix, tiles_are_stored_in_row_order)
+{
+	TTiledMatrix<int> m(8, 2, TILE_ROWS);
+	EXPECT_EQ(0, m.GetTileOffset(0, 0));
+	EXPECT_EQ(3, m.GetTileOffset(0, 1));
+	EXPECT_EQ(3 + 3 * 4, m.GetTileOffset(1, 1));
+}
+
+TEST(TTiledMatrix, conversion_to_and_from_row_layout_is_exact)
+{
+	for (int n : { 0, 1, 5, 16, 37 })
+		for (int t : { 1, 4, 8, 64 })
+			for (TTileOrder o : { TILE_ROWS, TILE_MORTON })
+			{
+				TMatrix<int> m = MakeTestMatrix<int>(n);
+				TTiledMatrix<int> tm(m, t, o);
+				for (int i = 0; i < n; i++)
+					for (int j = i; j < n; j++)
+						EXPECT_EQ(m[i][j], tm(i, j));
+				EXPECT_EQ(m, tm.ToMatrix());
+			}
+}
+
+TEST(TTiledMatrix, copied_matrix_is_equal_and_has_own_memory)
+{
+	TTiledMatrix<int> m(MakeTestMatrix<int>(9), 4);
+	TTiledMatrix<int> c(m);
+	EXPECT_EQ(m, c);
+	c(0, 8) = 100;
+	EXPECT_NE(m, c);
+}
+
+TEST(TTiledMatrix, matrices_with_different_layout_can_be_equal)
+{
+	TMatrix<int> m = MakeTestMatrix<int>(11);
+	EXPECT_EQ(TTiledMatrix<int>(m, 3, TILE_ROWS), TTiledMatrix<int>(m, 4, TILE_MORTON));
+}
+
+TEST(TTiledMatrix, product_matches_row_layout_product)
+{
+	for (int n : { 1, 6, 19, 70 })
+		for (int t : { 1, 4, 16 })
+			for (TTileOrder o : { TILE_ROWS, TILE_MORTON })
+			{
+				TMatrix<int> a = MakeTestMatrix<int>(n), b = a * a;
+				TTiledMatrix<int> ta(a, t, o), tb(b, t, o);
+				EXPECT_EQ(a * b, (ta * tb).ToMatrix());
+			}
+}
+
+TEST(TTiledMatrix, can_multiply_matrices_with_different_tiles)
+{
+	TMatrix<int> a = MakeTestMatrix<int>(13);
+	EXPECT_EQ(a * a, (TTiledMatrix<int>(a, 4) * TTiledMatrix<int>(a, 5)).ToMatrix());
+}
+
+TEST(TTiledMatrix, cant_multiply_matrices_with_not_equal_size)
+{
+	TTiledMatrix<int> a(3), b(4);
+	ASSERT_ANY_THROW(a * b);
+}
+
+TEST(TTiledMatrix, product_by_vector_matches_row_layout)
+{
+	for (int n : { 1, 9, 50 })
+	{
+		TMatrix<int> a = MakeTestMatrix<int>(n);
+		TTiledMatrix<int> ta(a, 8);
+		TVector<int> v(n);
+		for (int i = 0; i < n; i++)
+			v[i] = i % 7 - 3;
+		EXPECT_EQ(a * v, ta * v);
+		EXPECT_EQ(a.MulTransposed(v), ta.MulTransposed(v));
+	}
+}
+
+TEST(TTiledMatrix, can_solve_system)
+{
+	for (int n : { 1, 10, 45, 130 })
+	{
+		TMatrix<double> a = MakeTestMatrix<double>(n);
+		TTiledMatrix<double> ta(a, 16);
+		TVector<double> x(n);
+		for (int i = 0; i < n; i++)
+			x[i] = 1.0 + i % 3;
+		TVector<double> y = ta.Solve(a * x);
+		for (int i = 0; i < n; i++)
+			EXPECT_NEAR(x[i], y[i], 1e-9);
+	}
+}
+
+TEST(TTiledMatrix, throws_when_solve_singular_system)
+{
+	TTiledMatrix<double> a(MakeTestMatrix<double>(5), 2);
+	a(3, 3) = 0;
+	ASSERT_ANY_THROW(a.Solve(TVector<double>(5)));
+}
+
+TEST(TTiledMatrix, parallel_product_matches_serial)
+{
+	TMatrix<double> a = MakeTestMatrix<double>(150);
+	TTiledMatrix<double> ta(a, 16);
+	TTiledMatrix<double> s = ta * ta;
+	int threads = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(4);
+	SetParallelCutoff(0);
+	TTiledMatrix<double> p = ta * ta;
+	SetNumThreads(threads);
+	SetParallelCutoff(cutoff);
+	EXPECT_EQ(s, p);
+}
+
+TEST(TTiledMatrix, product_inside_parallel_task_matches_serial)
+{
+	TTiledMatrix<double> ta(MakeTestMatrix<double>(40), 8);
+	TTiledMatrix<double> s = ta * ta;
+	int threads = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(3);
+	SetParallelCutoff(0);
+	vector<TTiledMatrix<double> > p(6, TTiledMatrix<double>(1, 8));
+	ParallelTasks(6, 6 * 40 * 40, [&](int t) { p[t] = ta * ta; }); // вложенные задания
+	SetNumThreads(threads);
+	SetParallelCutoff(cutoff);
+	for (int t = 0; t < 6; t++)
+		EXPECT_EQ(s, p[t]);
+}
@@ -65,6 +65,7 @@ TEST(TMatrix, can_set_and_get_element)
 	EXPECT_EQ(m[1][1], 5);
 }
 
+#if UTMATRIX_BOUNDS_CHECK
 TEST(TMatrix, throws_when_set_element_with_negative_index)
 {
 	TMatrix<int> m(2);
@@ -77,6 +78,15 @@ TEST(TMatrix, throws_when_set_element_with_too_large_index)
 	ASSERT_ANY_THROW(m[5][0]);
 }
 
+TEST(TMatrix, throws_when_access_element_below_diagonal)
+{
+	TMatrix<int> m(3);
+	ASSERT_NO_THROW(m[1][2]);
+	ASSERT_ANY_THROW(m[1][0]);
+	ASSERT_ANY_THROW(m[2][3]);
+}
+#endif
+
 TEST(TMatrix, can_assign_matrix_to_itself)
 {
 	TMatrix<int> m(2);
@@ -191,4 +201,356 @@ TEST(TMatrix, cant_subtract_matrixes_with_not_equal_size)
 	TMatrix<int> m(2);
 	TMatrix<int> n(3);
 	ASSERT_ANY_THROW(m - n);
-}
\ No newline at end of file
+}
+TEST(TMatrix, rows_are_stored_in_one_contiguous_buffer)
+{
+	TMatrix<int> m(4);
+	EXPECT_EQ(10, m.GetPackedSize());
+	EXPECT_EQ(&m[0][3] + 1, &m[1][1]);
+	EXPECT_EQ(&m[2][3] + 1, &m[3][3]);
+	EXPECT_EQ(m.GetData() + m.GetRowOffset(2), &m[2][2]);
+}
+
+TEST(TMatrix, packed_buffer_is_aligned)
+{
+	TMatrix<double> m(7);
+	EXPECT_EQ(0u, reinterpret_cast<size_t>(m.GetData()) % MATRIX_ALIGNMENT);
+}
+
+TEST(TMatrix, can_convert_upper_triangular_vector_of_vectors)
+{
+	TVector<TVector<int> > v(2);
+	v[0] = TVector<int>(2, 0);
+	v[1] = TVector<int>(1, 1);
+	v[0][0] = 1;
+	v[0][1] = 3;
+	v[1][1] = 5;
+	TMatrix<int> m(v);
+	EXPECT_EQ(3, m[0][1]);
+	EXPECT_EQ(5, m[1][1]);
+}
+
+TEST(TMatrix, throws_when_convert_not_triangular_vector_of_vectors)
+{
+	TVector<TVector<int> > v(2);
+	v[0] = TVector<int>(2, 0);
+	v[1] = TVector<int>(2, 0);
+	ASSERT_ANY_THROW(TMatrix<int> m(v));
+}
+
+TEST(TMatrix, throws_when_assign_row_of_other_size)
+{
+	TMatrix<int> m(3);
+	ASSERT_ANY_THROW(m[1] = TVector<int>(3, 1));
+}
+
+TEST(TMatrix, moved_matrix_takes_source_memory)
+{
+	TMatrix<int> m(3);
+	m[0][2] = 4;
+	int *p = m.GetData();
+	TMatrix<int> n(move(m));
+	EXPECT_EQ(p, n.GetData());
+	EXPECT_EQ(4, n[0][2]);
+	EXPECT_EQ(0, m.GetSize());
+}
+
+TEST(TMatrix, sum_of_temporaries_reuses_their_memory)
+{
+	TMatrix<int> m(2), n(2);
+	m[0][1] = 3;
+	n[0][1] = 5;
+	TMatrix<int> t(m);
+	int *p = t.GetData();
+	TMatrix<int> s = move(t) + n - m;
+	EXPECT_EQ(p, s.GetData());
+	EXPECT_EQ(5, s[0][1]);
+}
+
+TEST(TMatrix, can_evaluate_chained_expression_in_place)
+{
+	TMatrix<int> m(2), n(2), s(2);
+	m[0][0] = 1;
+	m[0][1] = 3;
+	m[1][1] = 5;
+	n[0][0] = 0;
+	n[0][1] = 1;
+	n[1][1] = 0;
+	int *p = s.GetData();
+	s = m + n - m * 2;
+	EXPECT_EQ(p, s.GetData());
+	EXPECT_EQ(-1, s[0][0]);
+	EXPECT_EQ(-2, s[0][1]);
+	EXPECT_EQ(-5, s[1][1]);
+}
+
+TEST(TMatrix, expression_with_not_equal_sizes_throws_when_built)
+{
+	TMatrix<int> m(2), n(2), k(3);
+	ASSERT_ANY_THROW(m + n - k);
+}
+
+TEST(TMatrix, can_multiply_matrices_with_equal_size)
+{
+	TMatrix<int> m(2), n(2), s(2);
+	m[0][0] = 1;
+	m[0][1] = 2;
+	m[1][1] = 3;
+	n[0][0] = 4;
+	n[0][1] = 5;
+	n[1][1] = 6;
+	s[0][0] = 4;
+	s[0][1] = 17;
+	s[1][1] = 18;
+	EXPECT_EQ(s, m * n);
+}
+
+TEST(TMatrix, cant_multiply_matrices_with_not_equal_size)
+{
+	TMatrix<int> m(2);
+	TMatrix<int> n(3);
+	ASSERT_ANY_THROW(m * n);
+}
+
+TEST(TMatrix, blocked_product_matches_direct_one)
+{
+	for (int s : { 1, 5, 17, 70, 300, 600 })
+	{
+		TMatrix<long long> m(s), n(s);
+		for (int i = 0; i < s; i++)
+			for (int j = i; j < s; j++)
+			{
+				m[i][j] = (i * 7 + j * 3) % 11 - 5;
+				n[i][j] = (i * 5 + j) % 13 - 6;
+			}
+		TMatrix<long long> p = m * n;
+		for (int i = 0; i < s; i += 7)
+			for (int j = i; j < s; j += 3)
+			{
+				long long c = 0;
+				for (int k = i; k <= j; k++)
+					c += m[i][k] * n[k][j];
+				ASSERT_EQ(c, p[i][j]);
+			}
+	}
+}
+
+TEST(TMatrix, can_multiply_matrix_by_vector)
+{
+	TMatrix<int> m(2);
+	m[0][0] = 1;
+	m[0][1] = 2;
+	m[1][1] = 3;
+	TVector<int> v(2), r(2);
+	v[0] = 4;
+	v[1] = 5;
+	r[0] = 14;
+	r[1] = 15;
+	EXPECT_EQ(r, m * v);
+}
+
+TEST(TMatrix, can_multiply_transposed_matrix_by_vector)
+{
+	TMatrix<int> m(2);
+	m[0][0] = 1;
+	m[0][1] = 2;
+	m[1][1] = 3;
+	TVector<int> v(2), r(2);
+	v[0] = 4;
+	v[1] = 5;
+	r[0] = 4;
+	r[1] = 23;
+	EXPECT_EQ(r, m.MulTransposed(v));
+}
+
+TEST(TMatrix, cant_multiply_matrix_by_vector_with_not_equal_size)
+{
+	TMatrix<int> m(2);
+	TVector<int> v(3);
+	ASSERT_ANY_THROW(m * v);
+	ASSERT_ANY_THROW(m.MulTransposed(v));
+}
+
+TEST(TMatrix, matrix_vector_products_match_direct_ones)
+{
+	const int s = 45;
+	TMatrix<double> m(s);
+	TVector<double> v(s);
+	for (int i = 0; i < s; i++)
+	{
+		v[i] = i % 4 - 1.5;
+		for (int j = i; j < s; j++)
+			m[i][j] = (i + 2 * j) % 7 - 3;
+	}
+	TVector<double> y = m * v, t = m.MulTransposed(v);
+	for (int i = 0; i < s; i++)
+	{
+		double a = 0, b = 0;
+		for (int k = i; k < s; k++)
+			a += m[i][k] * v[k];
+		for (int k = 0; k <= i; k++)
+			b += m[k][i] * v[k];
+		EXPECT_DOUBLE_EQ(a, y[i]);
+		EXPECT_DOUBLE_EQ(b, t[i]);
+	}
+}
+
+TEST(TMatrix, can_solve_system)
+{
+	TMatrix<double> m(2);
+	m[0][0] = 2;
+	m[0][1] = 1;
+	m[1][1] = 4;
+	TVector<double> b(2);
+	b[0] = 4;
+	b[1] = 8;
+	TVector<double> x = m.Solve(b);
+	EXPECT_DOUBLE_EQ(1, x[0]);
+	EXPECT_DOUBLE_EQ(2, x[1]);
+}
+
+TEST(TMatrix, throws_when_solve_singular_system)
+{
+	TMatrix<double> m(2);
+	m[0][0] = 1;
+	m[0][1] = 1;
+	m[1][1] = 0;
+	TVector<double> b(2);
+	ASSERT_ANY_THROW(m.Solve(b));
+}
+
+TEST(TMatrix, throws_when_solve_system_with_not_equal_size)
+{
+	TMatrix<double> m(2);
+	TVector<double> b(3);
+	ASSERT_ANY_THROW(m.Solve(b));
+}
+
+TEST(TMatrix, blocked_solve_restores_right_hand_sides)
+{
+	const int s = 300, k = 5;
+	TMatrix<double> m(s);
+	for (int i = 0; i < s; i++)
+	{
+		m[i][i] = 4 + i % 3;
+		for (int j = i + 1; j < s; j++)
+			m[i][j] = ((i + j) % 5 - 2) / double(s);
+	}
+	TVector<TVector<double> > b(k);
+	for (int c = 0; c < k; c++)
+	{
+		b[c] = TVector<double>(s);
+		for (int i = 0; i < s; i++)
+			b[c][i] = (i * (c + 1)) % 9 - 4;
+	}
+	TVector<TVector<double> > x = m.Solve(b);
+	for (int c = 0; c < k; c++)
+	{
+		TVector<double> r = m * x[c], x1 = m.Solve(b[c]);
+		for (int i = 0; i < s; i++)
+		{
+			EXPECT_NEAR(b[c][i], r[i], 1e-12);
+			EXPECT_NEAR(x[c][i], x1[i], 1e-12);
+		}
+	}
+}
+
+TEST(TMatrix, blocked_solve_of_many_right_hand_sides_is_exact)
+{
+	const int s = 300, k = 37; // несколько панелей по строкам и столбцам
+	TMatrix<long long> m(s);
+	for (int i = 0; i < s; i++)
+	{
+		m[i][i] = 1;
+		for (int j = i + 1; j < s; j++)
+			m[i][j] = (i * 3 + j) % 3 - 1;
+	}
+	TVector<TVector<long long> > x(k), b(k);
+	for (int c = 0; c < k; c++)
+	{
+		x[c] = TVector<long long>(s);
+		for (int i = 0; i < s; i++)
+			x[c][i] = (i + c) % 7 - 3;
+		b[c] = m * x[c];
+	}
+	EXPECT_EQ(x, m.Solve(b));
+}
+
+TEST(TMatrix, can_add_and_scale_in_place)
+{
+	TMatrix<int> m(3), n(3);
+	for (int i = 0; i < 3; i++)
+		for (int j = i; j < 3; j++)
+		{
+			m[i][j] = i + j;
+			n[i][j] = 10;
+		}
+	m += n;
+	EXPECT_EQ(14, m[2][2]);
+	m *= 2;
+	EXPECT_EQ(28, m[2][2]);
+	m -= n * 2;
+	EXPECT_EQ(8, m[2][2]);
+	m.Axpy(3, n);
+	EXPECT_EQ(38, m[2][2]);
+	m += n - n * 2;
+	EXPECT_EQ(28, m[2][2]);
+}
+
+TEST(TMatrix, in_place_axpy_matches_expression_in_parallel)
+{
+	const int s = 200;
+	TMatrix<double> y(s), x(s);
+	for (int i = 0; i < s; i++)
+		for (int j = i; j < s; j++)
+		{
+			y[i][j] = i - j;
+			x[i][j] = 0.5 * j;
+		}
+	TMatrix<double> r(y + x * 1.5);
+	int old = GetNumThreads(), cutoff = GetParallelCutoff();
+	SetNumThreads(3);
+	SetParallelCutoff(100);
+	ResetBufferPoolStats();
+	y.Axpy(1.5, x);
+	EXPECT_EQ(0u, GetBufferPoolStats().Requests);
+	SetNumThreads(old);
+	SetParallelCutoff(cutoff);
+	EXPECT_EQ(r, y);
+}
+
+TEST(TMatrix, cant_add_in_place_matrices_with_not_equal_size)
+{
+	TMatrix<int> m(3), n(4);
+	ASSERT_ANY_THROW(m += n);
+	ASSERT_ANY_THROW(m.Axpy(1, n));
+}
+
+static double ConstMatrixTrace(const TMatrix<double> &m)
+{
+	double t = 0;
+	for (int i = 0; i < m.GetSize(); i++)
+		t += m[i][i];
+	return t;
+}
+
+TEST(TMatrix, const_matrix_supports_reading_and_arithmetic)
+{
+	TMatrix<double> m(4), n(4);
+	for (int i = 0; i < 4; i++)
+		for (int j = i; j < 4; j++)
+		{
+			m[i][j] = i + j + 1;
+			n[i][j] = 1;
+		}
+	const TMatrix<double> &cm = m, &cn = n;
+	static_assert(is_same<decltype(cm[1][2]), const double&>::value, "const operator[]");
+	ResetBufferPoolStats();
+	EXPECT_EQ(16.0, ConstMatrixTrace(cm));
+	EXPECT_EQ(0u, GetBufferPoolStats().Requests);
+	TMatrix<double> s(cm + cn);
+	EXPECT_EQ(1u, GetBufferPoolStats().Requests);
+	EXPECT_EQ(8.0, s[3][3]);
+	EXPECT_EQ(cm[1] * cm[1], 3.0 * 3.0 + 4.0 * 4.0 + 5.0 * 5.0);
+	EXPECT_TRUE(cm * cn != cn);
+}
@@ -81,6 +81,7 @@ TEST(TVector, can_set_and_get_element)
   EXPECT_EQ(4, v[0]);
 }
 
+#if UTMATRIX_BOUNDS_CHECK
 TEST(TVector, throws_when_set_element_with_negative_index)
 {
 	TVector<int> v(5);
@@ -93,6 +94,30 @@ TEST(TVector, throws_when_set_element_with_too_large_index)
 	ASSERT_ANY_THROW(v[6]);
 }
 
+TEST(TVector, throws_when_index_equals_size_plus_start_index)
+{
+	TVector<int> v(5, 2);
+	ASSERT_NO_THROW(v[6]);
+	ASSERT_ANY_THROW(v[7]);
+}
+
+TEST(TVector, throws_when_index_is_less_than_start_index)
+{
+	TVector<int> v(5, 2);
+	ASSERT_NO_THROW(v[2]);
+	ASSERT_ANY_THROW(v[1]);
+}
+#endif
+
+TEST(TVector, unchecked_access_addresses_same_element)
+{
+	TVector<int> v(5, 2);
+	v[4] = 7;
+	EXPECT_EQ(&v[4], &v.at_unchecked(4));
+	v.at_unchecked(6) = 9;
+	EXPECT_EQ(9, v[6]);
+}
+
 TEST(TVector, can_assign_vector_to_itself)
 {
 	TVector<int> v(5);
@@ -314,3 +339,210 @@ TEST(TVector, cant_multiply_vectors_with_not_equal_size)
 	ASSERT_ANY_THROW(a * v);
 }
 
+
+TEST(TVector, moved_vector_takes_source_memory)
+{
+	TVector<int> v(5);
+	v[0] = 1;
+	int *p = &v[0];
+	TVector<int> m(move(v));
+	EXPECT_EQ(p, &m[0]);
+	EXPECT_EQ(1, m[0]);
+	EXPECT_EQ(0, v.GetSize());
+}
+
+TEST(TVector, move_assign_takes_source_memory)
+{
+	TVector<int> v(5);
+	int *p = &v[0];
+	TVector<int> m(3);
+	m = move(v);
+	EXPECT_EQ(p, &m[0]);
+	EXPECT_EQ(5, m.GetSize());
+}
+
+TEST(TVector, operations_on_temporary_reuse_its_memory)
+{
+	TVector<int> v(3), a(3);
+	for (int i = 0; i < 3; i++)
+	{
+		v[i] = i;
+		a[i] = 10;
+	}
+	TVector<int> t(v);
+	int *p = &t[0];
+	TVector<int> r = (move(t) + a) * 2;
+	EXPECT_EQ(p, &r[0]);
+	EXPECT_EQ(24, r[2]);
+	TVector<int> u(v);
+	p = &u[0];
+	TVector<int> q = a - move(u);
+	EXPECT_EQ(p, &q[0]);
+	EXPECT_EQ(8, q[2]);
+}
+
+TEST(TVector, moving_matrix_row_copies_it)
+{
+	TMatrix<int> m(3);
+	m[1][2] = 7;
+	TVector<int> r(move(m[1]));
+	EXPECT_NE(&m[1][1], &r[1]);
+	EXPECT_EQ(7, m[1][2]);
+	EXPECT_EQ(7, r[2]);
+}
+
+TEST(TVector, can_evaluate_chained_expression)
+{
+	TVector<int> a(4), b(4), c(4);
+	for (int i = 0; i < 4; i++)
+	{
+		a[i] = i;
+		b[i] = 10 * i;
+		c[i] = 1;
+	}
+	TVector<int> r = a + b - c * 2 + 1;
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(11 * i - 1, r[i]);
+}
+
+TEST(TVector, expression_is_evaluated_in_place_of_equal_size_vector)
+{
+	TVector<int> a(3), b(3), r(3);
+	for (int i = 0; i < 3; i++)
+	{
+		a[i] = i;
+		b[i] = 1;
+	}
+	int *p = &r[0];
+	r = a + b - a;
+	EXPECT_EQ(p, &r[0]);
+	EXPECT_EQ(b, r);
+}
+
+TEST(TVector, can_assign_expression_containing_itself)
+{
+	TVector<int> a(3), b(3);
+	for (int i = 0; i < 3; i++)
+	{
+		a[i] = i;
+		b[i] = 5;
+	}
+	a = b + a * 2;
+	EXPECT_EQ(9, a[2]);
+}
+
+TEST(TVector, expression_with_not_equal_sizes_throws_when_built)
+{
+	TVector<int> a(3), b(3), c(4);
+	ASSERT_ANY_THROW(a + b - c);
+}
+
+TEST(TVector, can_multiply_expressions)
+{
+	TVector<int> a(3), b(3);
+	for (int i = 0; i < 3; i++)
+	{
+		a[i] = i;
+		b[i] = 1;
+	}
+	EXPECT_EQ(12, (a + b) * (b * 2));
+}
+
+TEST(TVector, can_add_and_subtract_in_place)
+{
+	TVector<int> a(4, 1), b(4);
+	for (int i = 0; i < 4; i++)
+	{
+		a[i + 1] = i;
+		b[i] = 10 * i;
+	}
+	a += b;
+	EXPECT_EQ(33, a[4]);
+	a -= b;
+	a -= b;
+	EXPECT_EQ(-27, a[4]);
+	EXPECT_EQ(1, a.GetStartIndex());
+}
+
+TEST(TVector, can_multiply_by_scalar_in_place)
+{
+	TVector<double> a(3);
+	for (int i = 0; i < 3; i++)
+		a[i] = i + 1;
+	a *= 0.5;
+	EXPECT_EQ(1.5, a[2]);
+}
+
+TEST(TVector, can_add_scaled_vector_in_place)
+{
+	TVector<double> y(100), x(100), r(100);
+	for (int i = 0; i < 100; i++)
+	{
+		y[i] = i;
+		x[i] = 1.0 - i;
+		r[i] = i + 3.0 * (1.0 - i);
+	}
+	TVector<double> z(y);
+	y.Axpy(3.0, x);
+	z += x * 3.0;
+	EXPECT_EQ(r, y);
+	EXPECT_EQ(r, z);
+	z -= x * 3.0;
+	y.Axpy(-3.0, x);
+	EXPECT_EQ(y, z);
+}
+
+TEST(TVector, can_add_expression_in_place)
+{
+	TVector<int> a(3), b(3), c(3);
+	for (int i = 0; i < 3; i++)
+	{
+		a[i] = i;
+		b[i] = 1;
+		c[i] = 2;
+	}
+	a += b + c * 2;
+	EXPECT_EQ(7, a[2]);
+	a -= a - b;
+	EXPECT_EQ(1, a[2]);
+}
+
+TEST(TVector, in_place_operations_do_not_allocate)
+{
+	TVector<float> a(1000), b(1000);
+	ResetBufferPoolStats();
+	a += b;
+	a -= b;
+	a *= 2.0f;
+	a.Axpy(2.0f, b);
+	a += b * 3.0f;
+	EXPECT_EQ(0u, GetBufferPoolStats().Requests);
+}
+
+TEST(TVector, cant_add_in_place_vectors_with_not_equal_size)
+{
+	TVector<int> a(3), b(4);
+	ASSERT_ANY_THROW(a += b);
+	ASSERT_ANY_THROW(a -= b);
+	ASSERT_ANY_THROW(a.Axpy(2, b));
+}
+
+TEST(TVector, const_vector_supports_reading_and_arithmetic)
+{
+	TVector<int> a(3, 1), b(3, 1);
+	for (int i = 1; i < 4; i++)
+	{
+		a[i] = i;
+		b[i] = 2;
+	}
+	const TVector<int> &ca = a, &cb = b;
+	static_assert(is_same<decltype(ca[1]), const int&>::value, "const operator[]");
+	EXPECT_EQ(3, ca[3]);
+	EXPECT_EQ(3, ca.at_unchecked(3));
+	EXPECT_EQ(12, ca * cb);
+	ResetBufferPoolStats();
+	TVector<int> s(ca + cb * 2);
+	EXPECT_EQ(1u, GetBufferPoolStats().Requests); // только результат
+	EXPECT_EQ(7, s[3]);
+	EXPECT_TRUE(ca != cb);
+}
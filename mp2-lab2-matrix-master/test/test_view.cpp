@@ -0,0 +1,167 @@
+#include "utview.h"
+
+#include <gtest.h>
+#include <sstream>
+
+// 1 2 3
+//   4 5
+//     6
+static TMatrix<int> MakeViewMatrix()
+{
+	TMatrix<int> m(3);
+	m[0][0] = 1;
+	m[0][1] = 2;
+	m[0][2] = 3;
+	m[1][1] = 4;
+	m[1][2] = 5;
+	m[2][2] = 6;
+	return m;
+}
+
+TEST(TTransposedView, element_i_j_is_element_j_i_of_matrix)
+{
+	TMatrix<int> m = MakeViewMatrix();
+	TTransposedView<int> t = Transpose(m);
+	EXPECT_EQ(3, t.GetSize());
+	EXPECT_EQ(1, t(0, 0));
+	EXPECT_EQ(2, t(1, 0));
+	EXPECT_EQ(5, t(2, 1));
+	EXPECT_EQ(6, t(2, 2));
+}
+
+TEST(TTransposedView, writes_through_view_change_matrix)
+{
+	TMatrix<int> m = MakeViewMatrix();
+	Transpose(m)(2, 0) = 10;
+	EXPECT_EQ(10, m[0][2]);
+}
+
+TEST(TTransposedView, view_does_not_copy_elements)
+{
+	TMatrix<int> m = MakeViewMatrix();
+	const TTransposedView<int> t = Transpose(m);
+	EXPECT_EQ(&m[1][2], &t(2, 1));
+}
+
+#if UTMATRIX_BOUNDS_CHECK
+TEST(TTransposedView, throws_when_access_above_diagonal)
+{
+	TMatrix<int> m = MakeViewMatrix();
+	ASSERT_ANY_THROW(Transpose(m)(0, 1));
+	ASSERT_ANY_THROW(Transpose(m)(3, 0));
+}
+#endif
+
+TEST(TTransposedView, can_multiply_view_by_vector)
+{
+	TMatrix<int> m = MakeViewMatrix();
+	TVector<int> v(3), r(3);
+	v[0] = 1;
+	v[1] = 2;
+	v[2] = 3;
+	r[0] = 1;              // 1
+	r[1] = 2 + 8;          // 2 4
+	r[2] = 3 + 10 + 18;    // 3 5 6
+	EXPECT_EQ(r, Transpose(m) * v);
+	EXPECT_EQ(m * v, Transpose(m).MulTransposed(v));
+}
+
+TEST(TTransposedView, can_solve_lower_triangular_system)
+{
+	int n = 150;
+	TMatrix<double> m(n);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			m[i][j] = (i == j) ? 3.0 + i % 4 : ((i + 2 * j) % 7 - 3) * 0.1;
+	TVector<double> x(n);
+	for (int i = 0; i < n; i++)
+		x[i] = i % 5 - 2.0;
+	TVector<double> y = Transpose(m).Solve(Transpose(m) * x);
+	for (int i = 0; i < n; i++)
+		EXPECT_NEAR(x[i], y[i], 1e-10);
+}
+
+TEST(TTransposedView, can_solve_with_several_right_hand_sides)
+{
+	TMatrix<double> m(3);
+	m[0][0] = 2;
+	m[0][1] = 1;
+	m[0][2] = -1;
+	m[1][1] = 4;
+	m[1][2] = 2;
+	m[2][2] = 5;
+	TVector<TVector<double> > b(2);
+	b[0] = TVector<double>(3);
+	b[1] = TVector<double>(3);
+	for (int i = 0; i < 3; i++)
+	{
+		b[0][i] = i + 1;
+		b[1][i] = 1 - i;
+	}
+	TVector<TVector<double> > x = Transpose(m).Solve(b);
+	for (int c = 0; c < 2; c++)
+	{
+		TVector<double> y = Transpose(m).Solve(b[c]);
+		for (int i = 0; i < 3; i++)
+			EXPECT_NEAR(y[i], x[c][i], 1e-12);
+	}
+}
+
+TEST(TTransposedView, throws_when_solve_singular_system)
+{
+	TMatrix<double> m(2);
+	m[0][0] = 1;
+	m[1][1] = 0;
+	ASSERT_ANY_THROW(Transpose(m).Solve(TVector<double>(2)));
+}
+
+TEST(TTransposedView, can_add_and_scale_views)
+{
+	TMatrix<int> a = MakeViewMatrix(), b = MakeViewMatrix() * 2, c(3);
+	Transpose(c) = Transpose(a) + Transpose(b) * 2;
+	EXPECT_EQ(a * 5, c);
+	Transpose(c) = Transpose(b) - Transpose(a);
+	EXPECT_EQ(a, c);
+}
+
+TEST(TTransposedView, cant_add_views_with_not_equal_size)
+{
+	TMatrix<int> a(2), b(3);
+	ASSERT_ANY_THROW(Transpose(a) + Transpose(b));
+}
+
+TEST(TTransposedView, assignment_copies_elements)
+{
+	TMatrix<int> a = MakeViewMatrix(), c(3);
+	TTransposedView<int> t = Transpose(c);
+	t = Transpose(a);
+	EXPECT_EQ(a, c);
+	EXPECT_TRUE(Transpose(a) == Transpose(c));
+}
+
+TEST(TTransposedView, can_print_lower_triangle)
+{
+	TMatrix<int> m = MakeViewMatrix();
+	ostringstream out;
+	out << Transpose(m);
+	EXPECT_EQ("1 \n2 4 \n3 5 6 \n", out.str());
+}
+
+TEST(TTransposedView, view_of_const_matrix_is_read_only)
+{
+	const TMatrix<int> m = MakeViewMatrix();
+	TTransposedView<const int> t = Transpose(m);
+	EXPECT_EQ(5, t(2, 1));
+	EXPECT_EQ(&m[1][2], &t(2, 1));
+	EXPECT_TRUE((is_same<decltype(Transpose(m)(2, 1)), const int&>::value));
+	EXPECT_FALSE((is_convertible<TTransposedView<const int>, TTransposedView<int> >::value));
+	TMatrix<int> c = MakeViewMatrix();
+	TTransposedView<const int> r = Transpose(c); // изменяемое -> только чтение
+	EXPECT_TRUE(r == t);
+	TVector<int> x(3);
+	for (int i = 0; i < 3; i++)
+		x[i] = i + 1;
+	EXPECT_EQ(Transpose(c) * x, t * x);
+	Transpose(c) = t + t;
+	EXPECT_EQ(m * 2, c);
+}